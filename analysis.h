@@ -0,0 +1,311 @@
+/* chronos/analysis.h
+ *
+ * Exact schedulability tests for a set of periodic tasks on one CPU:
+ *
+ *	- Fixed priority (RMA, ICPP): response time analysis, for tasks in
+ *	  any priority order; rate monotonic is what the schedulers use, and
+ *	  deadline monotonic is optimal. A task's response time includes the
+ *	  longest it can be blocked by lower priority tasks holding locks
+ *	  (see analysis_blocking()).
+ *	- EDF, and the utility accrual schedulers, which behave like EDF
+ *	  whenever EDF can meet every deadline: processor demand analysis.
+ *	  Rather than checking the demand at every deadline up to the end of
+ *	  the first busy period, QPA (Zhang & Burns) walks backwards from
+ *	  there, jumping straight to the demand wherever it is below the
+ *	  interval, and usually needs only a handful of steps. The busy
+ *	  period is bounded by L* below full utilization and by the
+ *	  hyperperiod at it.
+ *
+ * Times are integers in any one unit. Deadlines are relative and must
+ * not exceed periods.
+ *
+ * Author(s)
+ *	- Ben Weinstein-Raun, bwr@vt.edu
+ *
+ * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
+ */
+
+#ifndef _CHRONOS_ANALYSIS_H
+#define _CHRONOS_ANALYSIS_H
+
+#include <linux/errno.h>
+#include <linux/math64.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/types.h>
+
+#include "partition.h"
+
+struct analysis_task {
+	u64 period;
+	u64 deadline;
+	u64 exec;
+	// The longest it can be blocked by lower priority tasks
+	u64 block;
+};
+
+// Task (an index into the set) holds lock for up to length at a time
+struct analysis_cs {
+	int task;
+	int lock;
+	u64 length;
+};
+
+// Deadline monotonic priority order, for sort()
+static inline int analysis_dm_cmp(const void * a, const void * b)
+{
+	const struct analysis_task * x = a, * y = b;
+
+	if (x->deadline != y->deadline)
+		return x->deadline < y->deadline ? -1 : 1;
+	return (x->period > y->period) - (x->period < y->period);
+}
+
+// Rate monotonic priority order, for sort()
+static inline int analysis_rm_cmp(const void * a, const void * b)
+{
+	const struct analysis_task * x = a, * y = b;
+
+	if (x->period != y->period)
+		return x->period < y->period ? -1 : 1;
+	return (x->deadline > y->deadline) - (x->deadline < y->deadline);
+}
+
+/*
+ * Fill in each task's blocking term, for tasks in priority order. A
+ * lock's ceiling is the highest priority task that uses it; a task can
+ * only be blocked on locks whose ceiling is at least its own priority,
+ * by tasks below it.
+ *
+ * Under a ceiling protocol (ICPP) that happens at most once, for the
+ * longest such critical section. Under priority inheritance it can
+ * happen once per lock, so the longest section on each lock is added up.
+ */
+static inline int analysis_blocking(struct analysis_task * tasks, int nr,
+				    struct analysis_cs * cs, int nr_cs,
+				    int nr_locks, bool inheritance)
+{
+	int * ceiling;
+	u64 * longest;
+	int i, c;
+
+	ceiling = kmalloc(nr_locks * sizeof(*ceiling), GFP_KERNEL);
+	longest = kmalloc(nr_locks * sizeof(*longest), GFP_KERNEL);
+	if (ceiling == NULL || longest == NULL) {
+		kfree(ceiling);
+		kfree(longest);
+		return -ENOMEM;
+	}
+
+	for (c = 0; c < nr_locks; c++)
+		ceiling[c] = nr;
+	for (c = 0; c < nr_cs; c++)
+		ceiling[cs[c].lock] = min(ceiling[cs[c].lock], cs[c].task);
+
+	for (i = 0; i < nr; i++) {
+		memset(longest, 0, nr_locks * sizeof(*longest));
+		for (c = 0; c < nr_cs; c++)
+			if (cs[c].task > i && ceiling[cs[c].lock] <= i)
+				longest[cs[c].lock] = max(longest[cs[c].lock],
+							  cs[c].length);
+
+		tasks[i].block = 0;
+		for (c = 0; c < nr_locks; c++) {
+			if (inheritance)
+				tasks[i].block += longest[c];
+			else
+				tasks[i].block = max(tasks[i].block, longest[c]);
+		}
+	}
+
+	kfree(ceiling);
+	kfree(longest);
+	return 0;
+}
+
+/*
+ * Worst case response time of the task at index i of a set in priority
+ * order, or 0 if it exceeds its deadline.
+ */
+static inline u64 analysis_response_time(struct analysis_task * tasks, int i)
+{
+	u64 r = tasks[i].exec + tasks[i].block, prev = 0;
+	int j;
+
+	while (r != prev) {
+		if (r > tasks[i].deadline)
+			return 0;
+		prev = r;
+		r = tasks[i].exec + tasks[i].block;
+		for (j = 0; j < i; j++)
+			r += div64_u64(prev + tasks[j].period - 1, tasks[j].period) *
+				tasks[j].exec;
+	}
+	return r;
+}
+
+// The first task of a set in priority order to miss a deadline, or -1
+static inline int analysis_fp(struct analysis_task * tasks, int nr)
+{
+	int i;
+
+	for (i = 0; i < nr; i++)
+		if (analysis_response_time(tasks, i) == 0)
+			return i;
+	return -1;
+}
+
+// Work due by t, counting jobs released at 0 and every period after
+static inline u64 analysis_demand(struct analysis_task * tasks, int nr, u64 t)
+{
+	u64 h = 0;
+	int i;
+
+	for (i = 0; i < nr; i++)
+		if (t >= tasks[i].deadline)
+			h += (div64_u64(t - tasks[i].deadline, tasks[i].period) + 1) *
+				tasks[i].exec;
+	return h;
+}
+
+// The latest absolute deadline before t, or 0
+static inline u64 analysis_deadline_before(struct analysis_task * tasks,
+					   int nr, u64 t)
+{
+	u64 d, last = 0;
+	int i;
+
+	for (i = 0; i < nr; i++) {
+		if (t <= tasks[i].deadline)
+			continue;
+		d = div64_u64(t - tasks[i].deadline - 1, tasks[i].period) *
+			tasks[i].period + tasks[i].deadline;
+		last = max(last, d);
+	}
+	return last;
+}
+
+/*
+ * An upper bound on where demand can first exceed time, when utilization
+ * is below 1: max(dmax, sum (T - D) U / (1 - U)), rounded up throughout.
+ * U64_MAX if it can't be worked out without overflowing.
+ */
+static inline u64 analysis_demand_bound(struct analysis_task * tasks, int nr)
+{
+	u64 sum = 0, util = 0, dmax = 0, t;
+	int i;
+
+	for (i = 0; i < nr; i++) {
+		t = tasks[i].period - tasks[i].deadline;
+		if (tasks[i].exec > U64_MAX / PARTITION_UTIL_ONE ||
+		    (t && tasks[i].exec > U64_MAX / t))
+			return U64_MAX;
+		sum += div64_u64(t * tasks[i].exec + tasks[i].period - 1,
+				 tasks[i].period);
+		util += div64_u64(tasks[i].exec * PARTITION_UTIL_ONE +
+				  tasks[i].period - 1, tasks[i].period);
+		dmax = max(dmax, tasks[i].deadline);
+	}
+
+	if (util >= PARTITION_UTIL_ONE || sum > U64_MAX / PARTITION_UTIL_ONE)
+		return U64_MAX;
+	t = div64_u64(sum * PARTITION_UTIL_ONE + PARTITION_UTIL_ONE - util - 1,
+		      PARTITION_UTIL_ONE - util);
+	return max(dmax, t);
+}
+
+// Least common multiple of the periods, or U64_MAX if it overflows
+static inline u64 analysis_hyperperiod(struct analysis_task * tasks, int nr)
+{
+	u64 h = 1, p;
+	int i;
+
+	for (i = 0; i < nr; i++) {
+		p = div64_u64(tasks[i].period, gcd(h, tasks[i].period));
+		if (h > U64_MAX / p)
+			return U64_MAX;
+		h *= p;
+	}
+	return h;
+}
+
+/*
+ * Length of the synchronous busy period, or limit if it is longer. Only
+ * deadlines inside it need checking.
+ *
+ * At utilization up to 1 it ends by the hyperperiod, since no more work
+ * than that is released in one. Each step adds at least one job, so the
+ * number of steps is bounded by the jobs released before limit.
+ */
+static inline u64 analysis_busy_period(struct analysis_task * tasks, int nr,
+				       u64 limit)
+{
+	u64 w = 0, prev;
+	int i;
+
+	for (i = 0; i < nr; i++)
+		w += tasks[i].exec;
+
+	do {
+		if (w >= limit)
+			return limit;
+		prev = w;
+		w = 0;
+		for (i = 0; i < nr; i++)
+			w += div64_u64(prev + tasks[i].period - 1, tasks[i].period) *
+				tasks[i].exec;
+	} while (w != prev);
+
+	return w;
+}
+
+/*
+ * Is the set schedulable under EDF? If not and witness is given, it is
+ * set to an interval whose demand exceeds its length.
+ */
+static inline bool analysis_edf(struct analysis_task * tasks, int nr,
+				u64 * witness)
+{
+	u64 util = 0, dmin = U64_MAX, limit, t, h, num = 0, den = 1;
+	bool implicit = true;
+	int i;
+
+	if (witness)
+		*witness = 0;
+
+	for (i = 0; i < nr; i++) {
+		util += partition_util(tasks[i].period, tasks[i].exec);
+		dmin = min(dmin, tasks[i].deadline);
+		implicit &= tasks[i].deadline == tasks[i].period;
+	}
+
+	// Rounded up, so only a sum over 1 needs adding up exactly
+	if (util > PARTITION_UTIL_ONE)
+		for (i = 0; i < nr; i++)
+			if (!partition_util_add(&num, &den, tasks[i].period,
+						tasks[i].exec))
+				return false;
+	if (implicit || nr == 0)
+		return true;
+
+	// L* is only defined below full utilization
+	limit = analysis_demand_bound(tasks, nr);
+	if (limit == U64_MAX)
+		limit = analysis_hyperperiod(tasks, nr);
+	limit = analysis_busy_period(tasks, nr, limit);
+
+	t = analysis_deadline_before(tasks, nr, limit < U64_MAX ? limit + 1 : limit);
+	h = analysis_demand(tasks, nr, t);
+	while (h <= t && h > dmin) {
+		t = h < t ? h : analysis_deadline_before(tasks, nr, t);
+		h = analysis_demand(tasks, nr, t);
+	}
+
+	if (h <= dmin)
+		return true;
+	if (witness)
+		*witness = t;
+	return false;
+}
+
+#endif
@@ -12,114 +12,77 @@
 #include <linux/module.h>
 #include <linux/chronos_types.h>
 #include <linux/chronos_sched.h>
+#include <linux/errno.h>
 #include <linux/list.h>
+#include <linux/percpu.h>
 
-static inline int schedule_feasible(struct list_head * head, int i) {
-	struct rt_info * it;
-	struct timespec exec_ts = CURRENT_TIME;
-	list_for_each_entry(it, head, task_list[i]) {
-		add_ts(&exec_ts, &(it->left), &exec_ts);
-		if (earlier_deadline(&(it->deadline), &exec_ts)) return 0;
-	}
-	return 1;
-}
+#include "dasa_nd.h"
+#include "decision_cache.h"
+#include "ivd_cache.h"
+#include "sched_budget.h"
+#include "sched_trace.h"
+#include "sched_variant.h"
 
-struct rt_info* sched_dasa_nd(struct list_head *head, int flags)
-{
-	const int DENSITY_LIST = SCHED_LIST1;
-	const int SCHEDULE_LIST = SCHED_LIST2;
-	
-	// ChronOS seems to want to do everything to an rt_info* rather
-	// than the direct list_heads, while list.h expects a dummy list
-	// node to act as the head.
-	struct rt_info density_list;
-	struct rt_info schedule;
+static DEFINE_PER_CPU(struct rq_snapshot, snapshots);
+static DEFINE_PER_CPU(struct slack_pool, schedule_nodes);
+static DEFINE_PER_CPU(struct decision_cache, decisions);
 
+static __always_inline struct rt_info * __sched_dasa_nd(struct list_head *head,
+							int flags, const int variant)
+{
+	struct rq_snapshot * snap = this_cpu_ptr(&snapshots);
+	struct decision_cache * dc = this_cpu_ptr(&decisions);
 	struct rt_info * it;
+	struct sched_budget budget;
+	s64 horizon;
 
-	struct list_head * lit;
+	struct timespec now_ts = CURRENT_TIME;
+	s64 now = timespec_to_ns(&now_ts);
 
-	long ivd;
-	
-	struct timespec * t1;
+	// Nothing has happened that could change the last decision
+	it = decision_cache_get(dc, now, flags);
+	if (it != NULL)
+		return it;
 
-	INIT_LIST_HEAD(&(density_list.task_list[DENSITY_LIST]));
-	INIT_LIST_HEAD(&(schedule.task_list[SCHEDULE_LIST]));
+	sched_budget_start(&budget);
+	rq_snapshot_reset(snap);
 
 	// for each task in ready tasks,
 	list_for_each_entry(it, head, task_list[LOCAL_LIST]) {
 		// if a task is aborted, return it
-		if (check_task_failure(it, flags)) return it;
-
-		// The following call required adding an EXPORT_SYMBOL()
-		// even though it was non-static and had public prototypes.
-		// This probably won't work in stock ChronOS.
-
-		// compute task's IVD
-		livd(it, 0, flags);
-
-		
-		// initialize list heads
-		initialize_lists(it);
-
-		// add it to density list at the appropriate IVD
-		//list_add_after(&density_list, it, DENSITY_LIST);
-		//insert_on_list(it, &density_list, DENSITY_LIST, SORT_KEY_LVD, 1);
-		ivd = it->local_ivd;
-		lit = &(density_list.task_list[DENSITY_LIST]);
-		while (!list_is_last(lit, &(density_list.task_list[DENSITY_LIST]))) {
-			if (list_first_entry(lit,
-				struct rt_info,
-				task_list[DENSITY_LIST]
-				)->local_ivd > ivd)
-				break;
-			lit = lit->next;
-		}
-		list_add(&(it->task_list[DENSITY_LIST]), lit);
-		
-	}
+		if (sched_task_failed(it, now, variant)) return it;
 
-	// quicksort tasks by IVD
-	//quicksort(&density_list,
-			//DENSITY_LIST, 
-			//SORT_KEY_LVD, 1);
-
-	// for each task, by value density
-	list_for_each_entry(it, &(density_list.task_list[DENSITY_LIST]), task_list[DENSITY_LIST]) {
-		// add it to the schedule, sorted by deadline
-		//insert_on_list(it, &schedule, SCHEDULE_LIST, SORT_KEY_DEADLINE, 1);
-		t1 = &(it->deadline);
-		lit = &(schedule.task_list[SCHEDULE_LIST]);
-		while (!list_is_last(lit, &(schedule.task_list[SCHEDULE_LIST]))) {
-			if (earlier_deadline(&(list_first_entry(lit,
-							struct rt_info,
-							task_list[SCHEDULE_LIST]
-							)->deadline), t1))
-				break;
-			lit = lit->next;
-		}
-		list_add(&(it->task_list[SCHEDULE_LIST]), lit);
-
-		// check to see if schedule is feasible and, if not, remove it.
-		// I think this one also required an EXPORT_SYMBOL.
-		if (!schedule_feasible(&(schedule.task_list[SCHEDULE_LIST]), SCHEDULE_LIST))
-			list_remove(it, SCHEDULE_LIST);
+		// compute task's IVD, if it has changed
+		cached_livd(it, 0, flags);
+
+		if (rq_snapshot_add(snap, it))
+			return local_task(head->next);
 	}
 
-	// If we ended up with an empty schedule, it means that
-	// there are no feasible schedules, but nothing has yet blown
-	// a deadline. Fall back to the highest-value-density task.
-	// Otherwise, do what DASA is supposed to do (return the first
-	// thing in the schedule)
-	if (list_empty(&(schedule.task_list[SCHEDULE_LIST])))
-		return list_first_entry(&(density_list.task_list[DENSITY_LIST]),
-					struct rt_info,
-					 task_list[DENSITY_LIST]);
-	else
-		return list_first_entry(&(schedule.task_list[SCHEDULE_LIST]),
-					struct rt_info,
-					task_list[SCHEDULE_LIST]);
+	it = dasa_nd_decide(snap, this_cpu_ptr(&schedule_nodes), now, &budget,
+			    &horizon);
+	decision_cache_set(dc, it, now, horizon, flags);
+	return it;
+}
+
+// The ready set or its locks changed under the last decision
+static void dasa_nd_task_event(struct rt_info * task, int flags)
+{
+	decision_cache_invalidate(&per_cpu(decisions, task->cpu));
+}
 
+static void dasa_nd_lock_event(struct rt_info * task, struct mutex_head * m,
+			       int flags)
+{
+	decision_cache_invalidate(&per_cpu(decisions, task->cpu));
+}
+
+DEFINE_SCHED_VARIANTS(dasa_nd_variants, __sched_dasa_nd);
+
+struct rt_info * sched_dasa_nd(struct list_head *head, int flags)
+{
+	return sched_trace_decision(SCHED_RT_DASA_ND, head, flags,
+				    sched_variant(dasa_nd_variants, flags));
 }
 
 struct rt_sched_local dasa_nd = {
@@ -127,19 +90,49 @@ struct rt_sched_local dasa_nd = {
 	.base.id = SCHED_RT_DASA_ND,
 	.flags = 0,
 	.schedule = sched_dasa_nd,
-	.base.sort_key = SORT_KEY_PERIOD,
+	.enqueue = dasa_nd_task_event,
+	.dequeue = dasa_nd_task_event,
+	.lock = dasa_nd_lock_event,
+	.unlock = dasa_nd_lock_event,
+	.block = dasa_nd_lock_event,
+	.base.sort_key = SORT_KEY_DEADLINE,
 	.base.list = LIST_HEAD_INIT(dasa_nd.base.list)
 };
 
 static int __init dasa_nd_init(void)
 {
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		decision_cache_init(&per_cpu(decisions, cpu));
+		if (rq_snapshot_grow(&per_cpu(snapshots, cpu)) ||
+		    !slack_pool_get(&per_cpu(schedule_nodes, cpu),
+				    RQ_SNAPSHOT_PREALLOC))
+			goto nomem;
+	}
+
 	return add_local_scheduler(&dasa_nd);
+
+nomem:
+	for_each_possible_cpu(cpu) {
+		rq_snapshot_free(&per_cpu(snapshots, cpu));
+		slack_pool_free(&per_cpu(schedule_nodes, cpu));
+	}
+	return -ENOMEM;
 }
 module_init(dasa_nd_init);
 
 static void __exit dasa_nd_exit(void)
 {
+	int cpu;
+
 	remove_local_scheduler(&dasa_nd);
+
+	for_each_possible_cpu(cpu) {
+		rq_snapshot_free(&per_cpu(snapshots, cpu));
+		slack_pool_free(&per_cpu(schedule_nodes, cpu));
+		decision_cache_exit(&per_cpu(decisions, cpu));
+	}
 }
 module_exit(dasa_nd_exit);
 
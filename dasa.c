@@ -12,234 +12,575 @@
 #include <linux/module.h>
 #include <linux/chronos_types.h>
 #include <linux/chronos_sched.h>
+#include <linux/errno.h>
 #include <linux/list.h>
-#include <linux/list_sort.h>
+#include <linux/percpu.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/string.h>
+
+#include "decision_cache.h"
+#include "ivd_cache.h"
+#include "sched_budget.h"
+#include "sched_overhead.h"
+#include "sched_trace.h"
+#include "sched_variant.h"
 
-int task_cmp(void * arg, struct list_head * a, struct list_head * b) {
-	// Comparison function for list_sort
-	struct rt_info * a_task, * b_task;
-	int * field = (int *) arg;
+struct rt_info * first_dep(struct rt_info * task) {
+	if (task->requested_resource == NULL)
+		return NULL;
+	return task->requested_resource->owner_t;
+}
 
-	a_task = list_entry(a, struct rt_info, task_list[*field]);
-	b_task = list_entry(b, struct rt_info, task_list[*field]);
+/*
+ * The wait-for graph of a scheduling decision: one node per ready task,
+ * plus any task they wait on that isn't ready, and an edge from each task
+ * to the owner of the resource it requested. A task waits on at most one
+ * resource but may hold several, so many tasks can wait on one owner and
+ * every node has at most one edge out. The graph is then a forest of
+ * chains leading to a task that can run (its head), except where a chain
+ * closes on itself: those cycles are its only nontrivial strongly
+ * connected components, and they are exactly the deadlocks.
+ *
+ * dasa_graph_build() finds them in one walk over the graph, visiting
+ * each node once, and on the way back along each chain memoizes its head
+ * and the time and utility inherited from everything it waits on. That
+ * makes the whole decision's dependency work O(n + e), where walking each
+ * task's chain on its own is O(n * depth), and was done several times.
+ *
+ * The rest of the decision works on the graph's nodes too: their
+ * deadlines, remaining times and IVDs are copied into its arrays once,
+ * and the density order, the tentative schedule and the undo log are
+ * all kept there as node indices, so nothing but the build touches an
+ * rt_info. The arrays belong to the CPU and only grow, and start out big
+ * enough for DASA_PREALLOC tasks.
+ *
+ * A task's index in the graph is kept in heap_index, which DASA has no
+ * other use for.
+ */
+#define DASA_PREALLOC 64
+
+enum dasa_node_state {
+	NODE_NEW,
+	NODE_ON_PATH,
+	NODE_DONE,
+	// In the tentative schedule
+	NODE_SCHEDULED,
+};
 
-	if (*field == SCHED_LIST1) {
-		return a_task->local_ivd - b_task->local_ivd;
-	} else if (*field == SCHED_LIST3) {
-		return compare_ts(&(a_task->temp_deadline), &(b_task->temp_deadline)); // difference between temporary deadlines
-	}
+struct dasa_key {
+	long ivd;
+	int index;
+};
 
-	// assume field is SCHED_LIST2
-	return compare_ts(&(a_task->deadline), &(b_task->deadline));// difference between deadlines
-}
-
-void list_copy(struct list_head * a, int alist, struct list_head * b, int blist) {
-	struct list_head * astart, * bstart;
-	printk("copying list\n");
-
-	astart = a;
-	bstart = b;
-	
-	while (a->next != astart) {
-		// set b->next and b->next->prevb
-		printk("pointing b->next at a->next->b\n");
-		b->next = &(list_entry(a->next, struct rt_info, task_list[alist])->task_list[blist]);
-		printk("pointing a->next->b->prev at b\n");
-		list_entry(a->next, struct rt_info, task_list[alist])->task_list[blist].prev = b;
-		a = a->next;
-		b = b->next;
-	}
-	printk("closing loop\n");
+// One entry per node moved while trying to add a task (and its
+// dependencies) to the schedule, so the attempt can be rolled back.
+struct dasa_undo {
+	int node;
+	int prev;		// where it was in the schedule, or -1 if it wasn't
+	s64 temp_deadline;
+};
 
-	b->next = bstart;
-	bstart->prev = b;
-	printk("finished list copy\n");
+struct dasa_graph {
+	int nr;
+	int nr_ready;		// the first nr_ready nodes are the ready tasks
+	int nr_deps;		// how many of them wait on another
+	int size;
+
+	struct rt_info ** task;
+	int * dep;		// node waited on, or -1
+	int * head;		// task at the end of the chain, or -1 if deadlocked
+	long * chain_left;	// remaining time of the task and its chain, in us
+	unsigned long * chain_util;
+	unsigned char * state;
+	int * path;
+
+	s64 * deadline;
+	s64 * temp_deadline;
+	// remaining time, plus the overhead charge (see sched_overhead.h), in ns
+	s64 * left;
+	s64 charge;
+
+	// The ready tasks by ascending IVD
+	struct dasa_key * density;
+
+	// The schedule, in tentative deadline order, as a circular list
+	// through node indices with node nr as its head
+	int * next;
+	int * prev;
+
+	struct dasa_undo * undo;
+};
+
+static DEFINE_PER_CPU(struct dasa_graph, graphs);
+static DEFINE_PER_CPU(struct decision_cache, decisions);
+
+static void dasa_graph_free(struct dasa_graph * g) {
+	kfree(g->task);
+	kfree(g->dep);
+	kfree(g->head);
+	kfree(g->chain_left);
+	kfree(g->chain_util);
+	kfree(g->state);
+	kfree(g->path);
+	kfree(g->deadline);
+	kfree(g->temp_deadline);
+	kfree(g->left);
+	kfree(g->density);
+	kfree(g->next);
+	kfree(g->prev);
+	kfree(g->undo);
+	memset(g, 0, sizeof(*g));
 }
 
-int schedule_feasible(struct list_head * head, int i) {
-	printk("checking schedule feasibility\n");
-	struct rt_info * it;
-	struct timespec exec_ts = CURRENT_TIME;
-	list_for_each_entry(it, head, task_list[i]) {
-		add_ts(&exec_ts, &(it->left), &exec_ts);
-		if (earlier_deadline(&(it->deadline), &exec_ts)) {
-			printk("schedule infeasible\n");
-			return 0;
-		}
-	}
-	printk("schedule feasible\n");
-	return 1;
+#define __graph_grow(g, field, size, gfp) ({					\
+	void * __p = krealloc((g)->field, (size) * sizeof(*(g)->field), gfp);	\
+	if (__p != NULL)							\
+		(g)->field = __p;						\
+	__p != NULL;								\
+})
+
+static int dasa_graph_resize(struct dasa_graph * g, int size, gfp_t gfp) {
+	// One more link for the schedule's head
+	if (!__graph_grow(g, task, size, gfp) ||
+	    !__graph_grow(g, dep, size, gfp) ||
+	    !__graph_grow(g, head, size, gfp) ||
+	    !__graph_grow(g, chain_left, size, gfp) ||
+	    !__graph_grow(g, chain_util, size, gfp) ||
+	    !__graph_grow(g, state, size, gfp) ||
+	    !__graph_grow(g, path, size, gfp) ||
+	    !__graph_grow(g, deadline, size, gfp) ||
+	    !__graph_grow(g, temp_deadline, size, gfp) ||
+	    !__graph_grow(g, left, size, gfp) ||
+	    !__graph_grow(g, density, size, gfp) ||
+	    !__graph_grow(g, next, size + 1, gfp) ||
+	    !__graph_grow(g, prev, size + 1, gfp) ||
+	    !__graph_grow(g, undo, size, gfp))
+		return -ENOMEM;
+
+	g->size = size;
+	return 0;
 }
 
-struct rt_info * first_dep(struct rt_info * task) {
-	printk("finding first task dependency\n");
-	if (task->requested_resource == NULL) {
-		printk("no dependency\n");
-		return NULL;
+static inline bool dasa_graph_has(struct dasa_graph * g, struct rt_info * task) {
+	int i = task->heap_index;
+
+	return i >= 0 && i < g->nr && g->task[i] == task;
+}
+
+// The node for task, adding it if it isn't in the graph yet; -1 if the
+// graph can't grow
+static int dasa_graph_node(struct dasa_graph * g, struct rt_info * task) {
+	int i = g->nr;
+
+	if (dasa_graph_has(g, task))
+		return task->heap_index;
+	if (i == g->size &&
+	    dasa_graph_resize(g, g->size ? 2 * g->size : DASA_PREALLOC, GFP_ATOMIC))
+		return -1;
+
+	g->task[i] = task;
+	g->state[i] = NODE_NEW;
+	g->deadline[i] = timespec_to_ns(&task->deadline);
+	g->temp_deadline[i] = g->deadline[i];
+	g->left[i] = timespec_to_ns(&task->left) + g->charge;
+	task->heap_index = i;
+	g->nr++;
+	return i;
+}
+
+// Resolve node u once the node it waits on has been
+static void dasa_graph_resolve(struct dasa_graph * g, int u) {
+	struct rt_info * task = g->task[u];
+	int d = g->dep[u];
+
+	g->state[u] = NODE_DONE;
+	g->chain_left[u] = timespec_to_long(&task->left);
+	g->chain_util[u] = task->max_util;
+
+	if (d < 0) {
+		g->head[u] = u;
+		return;
 	}
-	else {
-		printk("dependency found\n");
-		return task->requested_resource->owner_t;
+
+	// A task waiting on a deadlock isn't deadlocked itself; it can go
+	// on once the cycle has been aborted
+	g->head[u] = g->head[d];
+	if (g->head[d] >= 0) {
+		g->chain_left[u] += g->chain_left[d];
+		g->chain_util[u] += g->chain_util[d];
 	}
 }
 
-bool mark_deps_and_deadlocks(struct rt_info * task) {
-	printk("marking dependencies and deadlocks\n");
+/*
+ * Build the wait-for graph of the ready tasks, setting each task's dep,
+ * and flag the tasks in every cycle DEADLOCKED. Returns -ENOMEM if the
+ * graph couldn't hold them all. Chains are only resolved if there are
+ * any edges; otherwise head and the chain sums are left unset.
+ */
+static int dasa_graph_build(struct dasa_graph * g, struct list_head * head) {
 	struct rt_info * it;
-	it = task;
-	while ((it->dep = first_dep(it)) != NULL && !task_check_flag(it, DEADLOCKED)) {
-		if (task_check_flag(it, MARKED))
-			task_set_flag(task, DEADLOCKED);
-		task_set_flag(it, MARKED);
-		it = it->dep;
+	int i, v, len, d;
+
+	g->nr = 0;
+	g->nr_deps = 0;
+	g->charge = sched_overhead_charge();
+	list_for_each_entry(it, head, task_list[LOCAL_LIST])
+		if (dasa_graph_node(g, it) < 0)
+			return -ENOMEM;
+	g->nr_ready = g->nr;
+
+	// The owners found here are added at the end, and get their own
+	// edges in turn
+	for (i = 0; i < g->nr; i++) {
+		it = g->task[i];
+		it->dep = first_dep(it);
+		d = it->dep ? dasa_graph_node(g, it->dep) : -1;
+		if (it->dep != NULL && d < 0)
+			return -ENOMEM;
+		g->dep[i] = d;
+		g->nr_deps += d >= 0;
 	}
-	printk("finished marking dependencies\n");
 
-	it = task;
+	if (g->nr_deps == 0)
+		return 0;
 
-	while (it != NULL && task_check_flag(it, MARKED)) {
-		task_clear_flag(it, MARKED);
-		it = it->dep;
+	for (i = 0; i < g->nr; i++) {
+		// Follow the chain from i until it reaches a node that is
+		// already resolved, runs out, or comes back on itself
+		len = 0;
+		for (v = i; v >= 0 && g->state[v] == NODE_NEW; v = g->dep[v]) {
+			g->state[v] = NODE_ON_PATH;
+			g->path[len++] = v;
+		}
+
+		if (v >= 0 && g->state[v] == NODE_ON_PATH) {
+			// The path from v on is a cycle
+			do {
+				d = g->path[--len];
+				g->state[d] = NODE_DONE;
+				g->head[d] = -1;
+				g->chain_left[d] = 0;
+				g->chain_util[d] = 0;
+				task_set_flag(g->task[d], DEADLOCKED);
+			} while (d != v);
+		}
+
+		while (len > 0)
+			dasa_graph_resolve(g, g->path[--len]);
 	}
-	printk("finished unmarking\n");
 
-	return task_check_flag(it, DEADLOCKED);
+	return 0;
 }
 
-void compute_dep_tentative_deadlines(struct rt_info * task) {
-	struct timespec earliest;
+// The task's IVD, inheriting from its chain as livd() does with
+// dependency inheritance, but from the chain sums already in the graph
+static long dasa_graph_ivd(struct dasa_graph * g, struct rt_info * task, int flags) {
+	int i = task->heap_index;
 
-	printk("computing tentative deadlines\n");
-	earliest = task->deadline;
-	task->temp_deadline = task->deadline;
+	if (g->dep[i] < 0 || task_check_flag(task, DEADLOCKED))
+		return cached_livd(task, false, flags);
 
-	while ((task = first_dep(task))) {
-		if (compare_ts(&(task->deadline), &earliest) < 0) {
-			earliest = task->deadline;
-		}
-		task->temp_deadline = earliest;
+	task_clear_flag(task, IVD_CACHED);
+	task->local_ivd = g->chain_util[i] ? g->chain_left[i] / g->chain_util[i] : LONG_MAX;
+	return task->local_ivd;
+}
+
+static int dasa_key_cmp(const void * a, const void * b) {
+	const struct dasa_key * x = a, * y = b;
+
+	if (x->ivd != y->ivd)
+		return x->ivd < y->ivd ? -1 : 1;
+	// Later in the ready queue first, as DASA has always broken ties
+	return y->index - x->index;
+}
+
+static inline void schedule_init(struct dasa_graph * g) {
+	g->next[g->nr] = g->prev[g->nr] = g->nr;
+}
+
+static inline void schedule_link(struct dasa_graph * g, int u, int after) {
+	g->prev[u] = after;
+	g->next[u] = g->next[after];
+	g->prev[g->next[after]] = u;
+	g->next[after] = u;
+}
+
+static inline void schedule_unlink(struct dasa_graph * g, int u) {
+	g->next[g->prev[u]] = g->next[u];
+	g->prev[g->next[u]] = g->prev[u];
+}
+
+// Insert a node into the schedule in tentative deadline order. It goes
+// ahead of nodes with the same tentative deadline, so a dependency always
+// lands before the task that is waiting on it.
+static void schedule_insert(struct dasa_graph * g, int u) {
+	int v;
+
+	for (v = g->next[g->nr]; v != g->nr; v = g->next[v])
+		if (g->temp_deadline[u] <= g->temp_deadline[v])
+			break;
+	schedule_link(g, u, g->prev[v]);
+}
+
+static int schedule_feasible(struct dasa_graph * g, s64 now) {
+	s64 finish = now;
+	int v;
+
+	sched_trace_check();
+	for (v = g->next[g->nr]; v != g->nr; v = g->next[v]) {
+		finish += g->left[v];
+		if (g->deadline[v] < finish)
+			return 0;
 	}
-	printk("done computing tentative deadlines\n");
+	return 1;
 }
 
-struct rt_info* sched_dasa(struct list_head *head, int flags)
-{
-	printk("Beginning scheduler\n");
-	int DENSITY_LIST = SCHED_LIST1;
-	int SCHEDULE_LIST = SCHED_LIST2;
-	int TENTATIVE_LIST = SCHED_LIST3;
+// Variant bit for a decision with dependencies in the ready queue; there
+// are none in the usual case, and the chains then need no handling
+#define DASA_DEPS	0x100
 
-	long ivd;
-	
-	struct list_head density_list, schedule, tentative;
+/*
+ * Decide on the graph just built, setting *horizon as decision_cache.h
+ * wants it. variant is as in sched_variant.h, plus DASA_DEPS. Tasks are
+ * only tried while budget lasts.
+ */
+static __always_inline struct rt_info * dasa_decide(struct dasa_graph * g,
+						    s64 now, int flags,
+						    struct sched_budget * budget,
+						    s64 * horizon,
+						    const int variant)
+{
+	int nr_undo, i, k, v;
 
-	struct rt_info * it, * task;
+	s64 earliest, finish;
 
-	INIT_LIST_HEAD(&density_list);
-	INIT_LIST_HEAD(&schedule);
-	INIT_LIST_HEAD(&tentative);
+	struct dasa_undo * undo = g->undo;
 
+	*horizon = S64_MAX;
 
 	// for each task in ready tasks,
-	list_for_each_entry(it, head, task_list[LOCAL_LIST]) {
-		// compute dependency list
-		// and check for deadlocks (setting DEADLOCKED flag; livd knows what to do with that)
-		mark_deps_and_deadlocks(it);
-
+	for (i = 0; i < g->nr_ready; i++) {
 		// compute task's LIVD, aborting deadlocks
-		ivd = livd(it, true, flags);
-		printk("computed ivd: %d\n", ivd);
+		if (variant & DASA_DEPS)
+			g->density[i].ivd = dasa_graph_ivd(g, g->task[i], flags);
+		else
+			g->density[i].ivd = cached_livd(g->task[i], false, flags);
+		g->density[i].index = i;
 	}
 
-
-	list_for_each_entry(it, head, task_list[LOCAL_LIST]) {
+	for (i = 0; i < g->nr_ready; i++) {
 		// if a task is aborted or failed, return it so it can finish aborting
-		if (check_task_failure(it, flags)) {
-			printk("returning failed task\n");
-			return it;
+		if (sched_task_failed(g->task[i], now, variant)) {
+			*horizon = now;
+			return g->task[i];
 		}
 
-		// initialize list heads
-		initialize_lists(it);
-
-		// add it to density list
-		list_add(&(it->task_list[DENSITY_LIST]), &density_list);
-		printk("added task with ivd %d to density list\n", it->local_ivd);
+		if (g->deadline[i] > now)
+			*horizon = min(*horizon, g->deadline[i]);
 	}
 
-
-	
-	printk("sorting tasks by VD\n");
 	// sort tasks by descending VD
-	list_sort((void *) &DENSITY_LIST, &density_list, task_cmp);
+	sort(g->density, g->nr_ready, sizeof(*g->density), dasa_key_cmp, NULL);
+
+	schedule_init(g);
 
 	// for each task, by value density
-	list_for_each_entry(it, &density_list, task_list[DENSITY_LIST]) {
-		printk("copying schedule into tentative schedule\n");
-		// make a tentative copy of the schedule
-		list_copy(&schedule, SCHEDULE_LIST, &tentative, TENTATIVE_LIST);
-
-		// compute tentative deadlines (deadline tightening)
-		compute_dep_tentative_deadlines(it);
-
-		// add task and its dependents to tentative list, in
-		// deadline/dependency-order
-		for (task = it; task != NULL; task = first_dep(task)) {
-			printk("adding item to tentative schedule\n");
-			if (task_check_flag(task, MARKED))
-				list_del_init(&(it->task_list[TENTATIVE_LIST]));
-			list_add(&(it->task_list[TENTATIVE_LIST]), &tentative);
+	for (k = 0; k < g->nr_ready; k++) {
+		// Out of time; what has been accepted so far is feasible
+		if (sched_budget_spent(budget))
+			break;
+
+		i = g->density[k].index;
+
+		if (!(variant & DASA_DEPS)) {
+			schedule_insert(g, i);
+			if (schedule_feasible(g, now))
+				continue;
+			sched_trace_shed(1);
+			schedule_unlink(g, i);
+			continue;
 		}
 
-		list_sort((void *) &TENTATIVE_LIST, &tentative, task_cmp);
-		
-		// if the tentative schedule is feasible, copy it to the final schedule
-		if (schedule_feasible(&tentative, TENTATIVE_LIST)) {
-			list_copy(&tentative, TENTATIVE_LIST, &schedule, SCHEDULE_LIST);
-			list_sort((void *) &SCHEDULE_LIST, &schedule, task_cmp);
-			list_for_each_entry(task, &schedule, task_list[SCHEDULE_LIST]) {
-				task_set_flag(task, MARKED);
+		// already scheduled as a dependency of a denser task
+		if (g->state[i] == NODE_SCHEDULED)
+			continue;
+
+		// add task and its dependencies to the schedule in place, in
+		// deadline/dependency-order, tightening each dependency's
+		// deadline to the earliest one waiting on it
+		nr_undo = 0;
+		earliest = g->deadline[i];
+		for (v = i; v >= 0 && nr_undo < g->nr; v = g->dep[v]) {
+			earliest = min(earliest, g->deadline[v]);
+
+			undo[nr_undo].node = v;
+			undo[nr_undo].temp_deadline = g->temp_deadline[v];
+
+			if (g->state[v] == NODE_SCHEDULED) {
+				// The rest of this chain is already scheduled
+				// ahead of this task, so it only has to move if
+				// its deadline got tighter.
+				if (earliest >= g->temp_deadline[v])
+					break;
+				undo[nr_undo].prev = g->prev[v];
+				schedule_unlink(g, v);
+			} else {
+				undo[nr_undo].prev = -1;
 			}
+
+			g->temp_deadline[v] = earliest;
+			schedule_insert(g, v);
+			nr_undo++;
 		}
 
+		if (schedule_feasible(g, now)) {
+			while (nr_undo--)
+				g->state[undo[nr_undo].node] = NODE_SCHEDULED;
+			continue;
+		}
+
+		// Otherwise undo the insertions newest first, so that every
+		// saved position is valid again by the time it's restored.
+		sched_trace_shed(1);
+		while (nr_undo--) {
+			v = undo[nr_undo].node;
+			schedule_unlink(g, v);
+			g->temp_deadline[v] = undo[nr_undo].temp_deadline;
+			if (undo[nr_undo].prev >= 0)
+				schedule_link(g, v, undo[nr_undo].prev);
+		}
 	}
 
-	list_for_each_entry(task, &schedule, task_list[SCHEDULE_LIST]) {
-		task_clear_flag(task, MARKED);
+	// The schedule stands until it runs out of slack
+	finish = 0;
+	for (v = g->next[g->nr]; v != g->nr; v = g->next[v]) {
+		finish += g->left[v];
+		*horizon = min(*horizon, g->deadline[v] - finish);
 	}
-	
+
 	// If we ended up with an empty schedule, it means that
 	// there are no feasible schedules, but nothing has yet blown
 	// a deadline. Fall back to the highest-value-density task.
 	// Otherwise, do what DASA is supposed to do (return the first
 	// thing in the schedule)
-	if (list_empty(&schedule))
-		 it = list_first_entry(&density_list, struct rt_info, task_list[DENSITY_LIST]);
+	if (g->next[g->nr] == g->nr)
+		v = g->density[0].index;
+	else
+		v = g->next[g->nr];
+
+	// Run whatever it is waiting on
+	if ((variant & DASA_DEPS) && g->head[v] >= 0)
+		v = g->head[v];
+
+	return g->task[v];
+}
+
+static __always_inline struct rt_info * __sched_dasa(struct list_head *head,
+						     int flags, const int variant)
+{
+	struct rt_info * it;
+
+	struct dasa_graph * g = this_cpu_ptr(&graphs);
+
+	struct decision_cache * dc = this_cpu_ptr(&decisions);
+
+	struct sched_budget budget;
+
+	struct timespec now_ts = CURRENT_TIME;
+	s64 now = timespec_to_ns(&now_ts), horizon;
+
+	// Nothing has happened that could change the last decision
+	it = decision_cache_get(dc, now, flags);
+	if (it != NULL || list_empty(head))
+		return it;
+
+	sched_budget_start(&budget);
+
+	// compute dependency lists and find deadlocks (setting DEADLOCKED
+	// flag; livd knows what to do with that)
+	if (dasa_graph_build(g, head)) {
+		// Out of memory; run anything that isn't blocked
+		list_for_each_entry(it, head, task_list[LOCAL_LIST])
+			if (first_dep(it) == NULL)
+				return it;
+		return list_first_entry(head, struct rt_info, task_list[LOCAL_LIST]);
+	}
+
+	if (g->nr_deps)
+		it = dasa_decide(g, now, flags, &budget, &horizon,
+				 variant | DASA_DEPS);
 	else
-		 it = list_first_entry(&schedule, struct rt_info, task_list[SCHEDULE_LIST]);
+		it = dasa_decide(g, now, flags, &budget, &horizon, variant);
 
-	while (it->dep != NULL) it = it->dep;
+	decision_cache_set(dc, it, now, horizon, flags);
 	return it;
 }
 
+DEFINE_SCHED_VARIANTS(dasa_variants, __sched_dasa);
+
+struct rt_info * sched_dasa(struct list_head *head, int flags)
+{
+	return sched_trace_decision(SCHED_RT_DASA, head, flags,
+				    sched_variant(dasa_variants, flags));
+}
+
+// The ready set or its locks changed under the last decision
+static void dasa_task_event(struct rt_info * task, int flags)
+{
+	decision_cache_invalidate(&per_cpu(decisions, task->cpu));
+}
+
+static void dasa_lock_event(struct rt_info * task, struct mutex_head * m,
+			    int flags)
+{
+	decision_cache_invalidate(&per_cpu(decisions, task->cpu));
+}
+
 struct rt_sched_local dasa = {
 	.base.name = "DASA",
 	.base.id = SCHED_RT_DASA,
 	.flags = 0,
 	.schedule = sched_dasa,
+	.enqueue = dasa_task_event,
+	.dequeue = dasa_task_event,
+	.lock = dasa_lock_event,
+	.unlock = dasa_lock_event,
+	.block = dasa_lock_event,
 	.base.sort_key = SORT_KEY_PERIOD,
 	.base.list = LIST_HEAD_INIT(dasa.base.list)
 };
 
 static int __init dasa_init(void)
 {
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		decision_cache_init(&per_cpu(decisions, cpu));
+		if (dasa_graph_resize(&per_cpu(graphs, cpu), DASA_PREALLOC,
+				      GFP_KERNEL))
+			goto nomem;
+	}
+
 	return add_local_scheduler(&dasa);
+
+nomem:
+	for_each_possible_cpu(cpu)
+		dasa_graph_free(&per_cpu(graphs, cpu));
+	return -ENOMEM;
 }
 module_init(dasa_init);
 
 static void __exit dasa_exit(void)
 {
+	int cpu;
+
 	remove_local_scheduler(&dasa);
+
+	for_each_possible_cpu(cpu) {
+		dasa_graph_free(&per_cpu(graphs, cpu));
+		decision_cache_exit(&per_cpu(decisions, cpu));
+	}
 }
 module_exit(dasa_exit);
 
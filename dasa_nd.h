@@ -0,0 +1,109 @@
+/* chronos/dasa_nd.h
+ *
+ * The DASA-ND decision proper, on a snapshot of a ready queue. Shared by
+ * the single-core DASA-ND module and G-DASA, which only differ in where
+ * the snapshot comes from.
+ *
+ * Author(s)
+ *	- Matthew Dellinger, mdelling@vt.edu
+ *	- Ben Weinstein-Raun, bwr@vt.edu
+ *
+ * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
+ */
+
+#ifndef _CHRONOS_DASA_ND_H
+#define _CHRONOS_DASA_ND_H
+
+#include <linux/chronos_types.h>
+
+#include "rq_snapshot.h"
+#include "sched_budget.h"
+#include "sched_trace.h"
+#include "slack_tree.h"
+
+/*
+ * Pick a task from the snapshot. The tasks' IVDs must be up to date and
+ * none of them failed. pool holds this CPU's schedule nodes. Tasks are
+ * only tried while budget lasts. If horizon is given, it is set to when
+ * the decision may next change with no event in between (see
+ * decision_cache.h).
+ */
+static inline struct rt_info * dasa_nd_decide(struct rq_snapshot * snap,
+					      struct slack_pool * pool, s64 now,
+					      struct sched_budget * budget,
+					      s64 * horizon)
+{
+	struct slack_tree schedule;
+	struct slack_node * nodes;
+	s64 next = S64_MAX;
+	int i, j;
+
+	if (snap->nr == 0)
+		return NULL;
+
+	if (horizon) {
+		next = snapshot_next_deadline(snap, now);
+		*horizon = next;
+	}
+
+	// A snapshot taken in deadline order is the EDF schedule. If all
+	// of it is feasible, every task would be accepted below and the
+	// earliest deadline would come out first anyway.
+	if (snap->sorted) {
+		sched_trace_check();
+		if (snapshot_first_infeasible(snap, now) == snap->nr) {
+			if (horizon)
+				*horizon = min(next, snapshot_latest_start(snap));
+			return snap->task[0];
+		}
+	}
+
+	// sort tasks by IVD
+	rq_snapshot_sort_ivd(snap);
+
+	nodes = slack_pool_get(pool, snap->nr);
+	if (nodes == NULL) {
+		if (horizon)
+			*horizon = now;
+		return snap->task[snap->order[0]];
+	}
+
+	slack_tree_init(&schedule);
+
+	// for each task, by value density
+	for (i = 0; i < snap->nr; i++) {
+		// Out of time; what has been accepted so far is feasible. A
+		// try is cheap next to reading the clock, so only look every
+		// few of them.
+		if (!(i & 7) && sched_budget_spent(budget))
+			break;
+
+		j = snap->order[i];
+
+		// add it to the schedule, sorted by deadline
+		__slack_node_init(&nodes[i], snap->task[j], snap->deadline[j],
+				  snap->deadline[j], snap->left[j]);
+		slack_insert(&schedule, &nodes[i]);
+
+		// check to see if schedule is feasible and, if not, remove it.
+		sched_trace_check();
+		if (!slack_feasible(&schedule, now)) {
+			slack_erase(&schedule, &nodes[i]);
+			sched_trace_shed(1);
+		}
+	}
+
+	// If we ended up with an empty schedule, it means that
+	// there are no feasible schedules, but nothing has yet blown
+	// a deadline. Fall back to the highest-value-density task.
+	// Otherwise, do what DASA is supposed to do (return the first
+	// thing in the schedule)
+	if (slack_tree_empty(&schedule))
+		return snap->task[snap->order[0]];
+
+	if (horizon)
+		*horizon = min(next, slack_latest_start(&schedule));
+	return slack_first(&schedule)->task;
+}
+
+#endif
@@ -0,0 +1,121 @@
+/* chronos/decision_cache.h
+ *
+ * Reuse of the last decision of a utility accrual scheduler.
+ *
+ * DASA, DASA-ND and LBESA build a whole schedule on every call, but the
+ * core calls them far more often than the ready set changes. Between two
+ * events (a release, a completion, an abort or a lock changing hands)
+ * time passing is all that happens, and it can only change the decision
+ * at a few points:
+ *
+ *	- a task's deadline, where it fails and, with SCHED_FLAG_HUA, is
+ *	  aborted,
+ *	- the point where the schedule that was accepted runs out of slack.
+ *	  Until then, whether or not its first task runs, every set of
+ *	  tasks the scheduler tried stays feasible or infeasible as it was:
+ *	  no task but the one running gets any closer to finishing, so
+ *	  finishing times only ever move later.
+ *
+ * The scheduler stores the task it picked with the earliest of those
+ * points, its horizon. A call before the horizon with no event since
+ * gets the same task back in O(1). The schedulers clear the cache from
+ * their enqueue, dequeue, lock, unlock and block hooks, and an hrtimer on
+ * the CPU asks for a reschedule at the horizon, so a deadline that falls
+ * between events is still acted on in time.
+ *
+ * The cache belongs to one CPU and is only touched with its runqueue
+ * locked. SCHED_FLAG_NO_CACHE turns it off, for timing whole decisions.
+ *
+ * Author(s)
+ *	- Ben Weinstein-Raun, bwr@vt.edu
+ *
+ * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
+ */
+
+#ifndef _CHRONOS_DECISION_CACHE_H
+#define _CHRONOS_DECISION_CACHE_H
+
+#include <linux/hrtimer.h>
+#include <linux/kernel.h>
+#include <linux/sched.h>
+#include <linux/time.h>
+#include <linux/types.h>
+#include <linux/chronos_types.h>
+#include <linux/chronos_sched.h>
+
+struct decision_cache {
+	// The last decision, or NULL if there is none to reuse
+	struct rt_info * task;
+	int flags;
+	// It stands from since until before horizon (ns)
+	s64 since;
+	s64 horizon;
+
+	struct hrtimer timer;
+};
+
+static enum hrtimer_restart decision_cache_expire(struct hrtimer * timer)
+{
+	set_need_resched();
+	return HRTIMER_NORESTART;
+}
+
+static inline void decision_cache_init(struct decision_cache * dc)
+{
+	dc->task = NULL;
+	hrtimer_init(&dc->timer, CLOCK_REALTIME, HRTIMER_MODE_ABS_PINNED);
+	dc->timer.function = decision_cache_expire;
+}
+
+static inline void decision_cache_exit(struct decision_cache * dc)
+{
+	hrtimer_cancel(&dc->timer);
+}
+
+static inline void decision_cache_invalidate(struct decision_cache * dc)
+{
+	dc->task = NULL;
+}
+
+// The last decision, if it still stands at now; NULL otherwise, and
+// the decision made instead has to be stored again to be reused
+static inline struct rt_info * decision_cache_get(struct decision_cache * dc,
+						  s64 now, int flags)
+{
+	struct rt_info * task = dc->task;
+
+	if (task == NULL)
+		return NULL;
+	if (flags != dc->flags || now < dc->since || now >= dc->horizon ||
+	    check_task_aborted(task)) {
+		dc->task = NULL;
+		return NULL;
+	}
+	return task;
+}
+
+/*
+ * Remember task as the decision made at now, good until horizon. The
+ * timer is only moved when the horizon does; a timer left over from an
+ * earlier horizon costs no more than a spurious reschedule.
+ */
+static inline void decision_cache_set(struct decision_cache * dc,
+				      struct rt_info * task, s64 now,
+				      s64 horizon, int flags)
+{
+	if (task == NULL || horizon <= now || (flags & SCHED_FLAG_NO_CACHE)) {
+		dc->task = NULL;
+		return;
+	}
+
+	if (horizon != S64_MAX && (!dc->task || horizon != dc->horizon))
+		hrtimer_start(&dc->timer, ns_to_ktime(horizon),
+			      HRTIMER_MODE_ABS_PINNED);
+
+	dc->task = task;
+	dc->flags = flags;
+	dc->since = now;
+	dc->horizon = horizon;
+}
+
+#endif
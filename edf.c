@@ -12,28 +12,191 @@
 #include <linux/module.h>
 #include <linux/chronos_types.h>
 #include <linux/chronos_sched.h>
+#include <linux/errno.h>
 #include <linux/list.h>
+#include <linux/percpu.h>
+#include <linux/slab.h>
 
-struct rt_info * sched_edf(struct list_head *head, int flags)
+#include "rq_snapshot.h"
+#include "sched_trace.h"
+
+/*
+ * Each CPU keeps its ready tasks in a min-heap on absolute deadline,
+ * maintained as tasks are released and complete. The earliest deadline
+ * is then always at the top, and the scheduler never has to look at the
+ * ready list at all.
+ */
+struct edf_entry {
+	s64 deadline;
+	struct rt_info * task;
+};
+
+struct edf_queue {
+	struct edf_entry * heap;
+	int nr;
+	int size;
+	// Ready tasks that didn't fit because the heap couldn't grow. While
+	// there are any, schedule by scanning the ready list instead.
+	int missing;
+};
+
+static DEFINE_PER_CPU(struct edf_queue, edf_queues);
+static DEFINE_PER_CPU(struct rq_snapshot, snapshots);
+
+static inline void edf_set(struct edf_queue * q, int i, struct edf_entry e)
 {
-	struct rt_info * best = local_task(head);
-	struct rt_info * um = local_task(head);
+	q->heap[i] = e;
+	e.task->heap_index = i;
+}
 
-	struct list_head * node;
-	list_for_each(node, head) {
-		int secdiff;
+static void edf_sift_up(struct edf_queue * q, int i)
+{
+	struct edf_entry e = q->heap[i];
 
-		um = local_task(node);
-		secdiff = um->deadline.tv_sec - best->deadline.tv_sec;
-		if (secdiff < 0) best = um;
-		else if (secdiff == 0 &&
-			 um->deadline.tv_nsec - best->deadline.tv_nsec < 0) best = um;
+	while (i > 0 && e.deadline < q->heap[(i - 1) / 2].deadline) {
+		edf_set(q, i, q->heap[(i - 1) / 2]);
+		i = (i - 1) / 2;
 	}
+	edf_set(q, i, e);
+}
 
-	//if(flags & SCHED_FLAG_PI)
-	//	best = get_pi_task(best, head, flags);
+static void edf_sift_down(struct edf_queue * q, int i)
+{
+	struct edf_entry e = q->heap[i];
+	int child;
 
-	return best;
+	while ((child = 2 * i + 1) < q->nr) {
+		if (child + 1 < q->nr &&
+		    q->heap[child + 1].deadline < q->heap[child].deadline)
+			child++;
+		if (e.deadline <= q->heap[child].deadline)
+			break;
+		edf_set(q, i, q->heap[child]);
+		i = child;
+	}
+	edf_set(q, i, e);
+}
+
+// Make room for nr more tasks
+static int edf_reserve(struct edf_queue * q, int nr)
+{
+	struct edf_entry * heap;
+	int size = q->size ? q->size : 64;
+
+	if (q->nr + nr <= q->size)
+		return 0;
+
+	while (size < q->nr + nr)
+		size *= 2;
+	heap = krealloc(q->heap, size * sizeof(*heap), GFP_ATOMIC);
+	if (heap == NULL)
+		return -ENOMEM;
+	q->heap = heap;
+	q->size = size;
+	return 0;
+}
+
+static inline void edf_append(struct edf_queue * q, struct rt_info * task)
+{
+	q->heap[q->nr].deadline = timespec_to_ns(&task->deadline);
+	q->heap[q->nr].task = task;
+	task->heap_index = q->nr++;
+}
+
+void enqueue_edf(struct rt_info * task, int flags)
+{
+	struct edf_queue * q = &per_cpu(edf_queues, task->cpu);
+
+	if (edf_reserve(q, 1)) {
+		q->missing++;
+		task->heap_index = -1;
+		return;
+	}
+
+	edf_append(q, task);
+	edf_sift_up(q, q->nr - 1);
+}
+
+/*
+ * Jobs released together go on the end of the heap, and then either
+ * each sifts up or, when there are as many of them as there were tasks
+ * already, the whole heap is rebuilt bottom-up in O(n) instead.
+ */
+void enqueue_batch_edf(struct rt_info ** tasks, int nr, int flags)
+{
+	struct edf_queue * q = &per_cpu(edf_queues, tasks[0]->cpu);
+	int old = q->nr, i;
+
+	if (edf_reserve(q, nr)) {
+		for (i = 0; i < nr; i++)
+			enqueue_edf(tasks[i], flags);
+		return;
+	}
+
+	for (i = 0; i < nr; i++)
+		edf_append(q, tasks[i]);
+
+	if (nr < old) {
+		for (i = old; i < q->nr; i++)
+			edf_sift_up(q, i);
+	} else {
+		for (i = q->nr / 2 - 1; i >= 0; i--)
+			edf_sift_down(q, i);
+	}
+}
+
+void dequeue_edf(struct rt_info * task, int flags)
+{
+	struct edf_queue * q = &per_cpu(edf_queues, task->cpu);
+	struct rt_info * moved;
+	int i = task->heap_index;
+
+	if (i < 0) {
+		q->missing--;
+		return;
+	}
+	if (i >= q->nr || q->heap[i].task != task)
+		return;
+
+	// Fill the hole with the last entry and let it find its place
+	if (i != --q->nr) {
+		moved = q->heap[q->nr].task;
+		edf_set(q, i, q->heap[q->nr]);
+		edf_sift_up(q, i);
+		edf_sift_down(q, moved->heap_index);
+	}
+}
+
+// Fallback for when the heap is out of sync with the ready list
+static struct rt_info * edf_scan(struct list_head *head)
+{
+	struct rq_snapshot * snap = this_cpu_ptr(&snapshots);
+	struct rt_info * um;
+
+	rq_snapshot_reset(snap);
+	list_for_each_entry(um, head, task_list[LOCAL_LIST]) {
+		if (rq_snapshot_add(snap, um))
+			return local_task(head->next);
+	}
+
+	if (snap->nr == 0)
+		return NULL;
+	return snap->task[snapshot_argmin_deadline(snap)];
+}
+
+static struct rt_info * __sched_edf(struct list_head *head, int flags)
+{
+	struct edf_queue * q = this_cpu_ptr(&edf_queues);
+
+	if (q->nr == 0 || q->missing)
+		return edf_scan(head);
+
+	return q->heap[0].task;
+}
+
+struct rt_info * sched_edf(struct list_head *head, int flags)
+{
+	return sched_trace_decision(SCHED_RT_EDF, head, flags, __sched_edf);
 }
 
 struct rt_sched_local edf = {
@@ -41,6 +204,9 @@ struct rt_sched_local edf = {
 	.base.id = SCHED_RT_EDF,
 	.flags = 0,
 	.schedule = sched_edf,
+	.enqueue = enqueue_edf,
+	.dequeue = dequeue_edf,
+	.enqueue_batch = enqueue_batch_edf,
 	.base.sort_key = SORT_KEY_PERIOD,
 	.base.list = LIST_HEAD_INIT(edf.base.list)
 };
@@ -53,7 +219,14 @@ module_init(edf_init);
 
 static void __exit edf_exit(void)
 {
+	int cpu;
+
 	remove_local_scheduler(&edf);
+
+	for_each_possible_cpu(cpu) {
+		kfree(per_cpu(edf_queues, cpu).heap);
+		rq_snapshot_free(&per_cpu(snapshots, cpu));
+	}
 }
 module_exit(edf_exit);
 
@@ -0,0 +1,186 @@
+/* chronos/gdasa.c
+ *
+ * Global DASA Scheduler Module for ChronOS
+ *
+ * Every CPU keeps its own ready queue, pulls earlier work from the other
+ * CPUs the same way G-EDF does (see global_queue.h), and makes the
+ * DASA-ND decision over what it holds. Underloaded, that runs the
+ * earliest deadlines everywhere, like G-EDF. Overloaded, each CPU sheds
+ * its own least valuable work.
+ *
+ * Author(s)
+ *	- Ben Weinstein-Raun, bwr@vt.edu
+ *
+ * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
+ */
+
+#include <linux/module.h>
+#include <linux/chronos_types.h>
+#include <linux/chronos_sched.h>
+#include <linux/errno.h>
+#include <linux/percpu.h>
+
+#include "dasa_nd.h"
+#include "global_queue.h"
+#include "ivd_cache.h"
+#include "sched_budget.h"
+#include "sched_overhead.h"
+#include "sched_trace.h"
+#include "sched_variant.h"
+
+static DEFINE_PER_CPU(struct global_queue, gdasa_queues);
+static DEFINE_PER_CPU(struct rq_snapshot, snapshots);
+static DEFINE_PER_CPU(struct slack_pool, schedule_nodes);
+
+static struct global_queue * gdasa_queue(int cpu)
+{
+	return &per_cpu(gdasa_queues, cpu);
+}
+
+void enqueue_gdasa(struct rt_info * task, int flags)
+{
+	struct global_queue * q = gdasa_queue(task->cpu);
+	s64 deadline = timespec_to_ns(&task->deadline);
+
+	raw_spin_lock(&q->lock);
+	gq_enqueue(q, task);
+	raw_spin_unlock(&q->lock);
+
+	gq_preempt(gdasa_queue, deadline);
+}
+
+void dequeue_gdasa(struct rt_info * task, int flags)
+{
+	struct global_queue * q = gq_lock_task(gdasa_queue, task);
+
+	gq_dequeue(q, task);
+	raw_spin_unlock(&q->lock);
+}
+
+// Snapshot q and decide; q must be locked. variant is as in
+// sched_variant.h.
+static __always_inline struct rt_info * gdasa_decide(struct global_queue * q,
+						     int flags, const int variant)
+{
+	struct rq_snapshot * snap = this_cpu_ptr(&snapshots);
+	struct rt_info * it;
+	struct sched_budget budget;
+	int i;
+
+	struct timespec now_ts = CURRENT_TIME;
+	s64 now = timespec_to_ns(&now_ts);
+
+	sched_budget_start(&budget);
+	rq_snapshot_reset(snap);
+
+	for (i = 0; i < q->nr; i++) {
+		it = gq_entry(q, i)->task;
+
+		// if a task is aborted, return it
+		if (sched_task_failed(it, now, variant))
+			return it;
+
+		cached_livd(it, 0, flags);
+
+		if (rq_snapshot_add(snap, it))
+			return gq_first(q);
+	}
+
+	list_for_each_entry(it, &q->overflow, task_list[GQ_OVERFLOW_LIST]) {
+		if (sched_task_failed(it, now, variant))
+			return it;
+
+		cached_livd(it, 0, flags);
+
+		if (rq_snapshot_add(snap, it))
+			return gq_first(q);
+	}
+
+	return dasa_nd_decide(snap, this_cpu_ptr(&schedule_nodes), now, &budget,
+			      NULL);
+}
+
+struct rt_info * sched_gdasa(int flags)
+{
+	int cpu = smp_processor_id();
+	struct global_queue * q = gdasa_queue(cpu);
+	struct rt_info * best;
+	bool trace = sched_trace_on();
+	u64 start;
+
+	if (trace)
+		sched_trace_begin(0);
+	start = sched_overhead_start();
+
+	raw_spin_lock(&q->lock);
+
+	gq_drain_overflow(q);
+	gq_balance(q, cpu, gdasa_queue);
+
+	if (flags & SCHED_FLAG_HUA)
+		best = gdasa_decide(q, flags, SCHED_FLAG_HUA);
+	else
+		best = gdasa_decide(q, flags, 0);
+	gq_run(q, best);
+	sched_trace_ready(q->nr);
+
+	raw_spin_unlock(&q->lock);
+
+	sched_overhead_decision(start);
+	sched_stats_decision(best);
+	if (trace)
+		sched_trace_end(SCHED_RT_GDASA, best);
+	return best;
+}
+
+struct rt_sched_global gdasa = {
+	.base.name = "G_DASA",
+	.base.id = SCHED_RT_GDASA,
+	.flags = 0,
+	.schedule = sched_gdasa,
+	.enqueue = enqueue_gdasa,
+	.dequeue = dequeue_gdasa,
+	.base.sort_key = SORT_KEY_DEADLINE,
+	.base.list = LIST_HEAD_INIT(gdasa.base.list)
+};
+
+static int __init gdasa_init(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		gq_init(gdasa_queue(cpu));
+		if (rq_snapshot_grow(&per_cpu(snapshots, cpu)) ||
+		    !slack_pool_get(&per_cpu(schedule_nodes, cpu),
+				    RQ_SNAPSHOT_PREALLOC))
+			goto nomem;
+	}
+
+	return add_global_scheduler(&gdasa);
+
+nomem:
+	for_each_possible_cpu(cpu) {
+		rq_snapshot_free(&per_cpu(snapshots, cpu));
+		slack_pool_free(&per_cpu(schedule_nodes, cpu));
+	}
+	return -ENOMEM;
+}
+module_init(gdasa_init);
+
+static void __exit gdasa_exit(void)
+{
+	int cpu;
+
+	remove_global_scheduler(&gdasa);
+
+	for_each_possible_cpu(cpu) {
+		gq_free(gdasa_queue(cpu));
+		rq_snapshot_free(&per_cpu(snapshots, cpu));
+		slack_pool_free(&per_cpu(schedule_nodes, cpu));
+	}
+}
+module_exit(gdasa_exit);
+
+MODULE_DESCRIPTION("Global DASA Scheduling Module for ChronOS");
+MODULE_AUTHOR("Ben Weinstein-Raun <b@w-r.me>");
+MODULE_LICENSE("GPL");
@@ -0,0 +1,115 @@
+/* chronos/gedf.c
+ *
+ * Global EDF Scheduler Module for ChronOS
+ *
+ * Runs the earliest deadline ready tasks across all CPUs. Every CPU
+ * schedules from its own queue and pulls earlier work from the others,
+ * see global_queue.h.
+ *
+ * Author(s)
+ *	- Ben Weinstein-Raun, bwr@vt.edu
+ *
+ * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
+ */
+
+#include <linux/module.h>
+#include <linux/chronos_types.h>
+#include <linux/chronos_sched.h>
+#include <linux/percpu.h>
+
+#include "global_queue.h"
+#include "sched_trace.h"
+
+static DEFINE_PER_CPU(struct global_queue, gedf_queues);
+
+static struct global_queue * gedf_queue(int cpu)
+{
+	return &per_cpu(gedf_queues, cpu);
+}
+
+void enqueue_gedf(struct rt_info * task, int flags)
+{
+	struct global_queue * q = gedf_queue(task->cpu);
+	s64 deadline = timespec_to_ns(&task->deadline);
+
+	raw_spin_lock(&q->lock);
+	gq_enqueue(q, task);
+	raw_spin_unlock(&q->lock);
+
+	gq_preempt(gedf_queue, deadline);
+}
+
+void dequeue_gedf(struct rt_info * task, int flags)
+{
+	struct global_queue * q = gq_lock_task(gedf_queue, task);
+
+	gq_dequeue(q, task);
+	raw_spin_unlock(&q->lock);
+}
+
+struct rt_info * sched_gedf(int flags)
+{
+	int cpu = smp_processor_id();
+	struct global_queue * q = gedf_queue(cpu);
+	struct rt_info * best;
+	bool trace = sched_trace_on();
+
+	if (trace)
+		sched_trace_begin(0);
+
+	raw_spin_lock(&q->lock);
+
+	gq_drain_overflow(q);
+
+	// Pull the earliest task another CPU isn't running, if it beats
+	// everything here
+	gq_balance(q, cpu, gedf_queue);
+
+	best = gq_first(q);
+	gq_run(q, best);
+	sched_trace_ready(q->nr);
+
+	raw_spin_unlock(&q->lock);
+
+	sched_stats_decision(best);
+	if (trace)
+		sched_trace_end(SCHED_RT_GEDF, best);
+	return best;
+}
+
+struct rt_sched_global gedf = {
+	.base.name = "G_EDF",
+	.base.id = SCHED_RT_GEDF,
+	.flags = 0,
+	.schedule = sched_gedf,
+	.enqueue = enqueue_gedf,
+	.dequeue = dequeue_gedf,
+	.base.sort_key = SORT_KEY_DEADLINE,
+	.base.list = LIST_HEAD_INIT(gedf.base.list)
+};
+
+static int __init gedf_init(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		gq_init(gedf_queue(cpu));
+
+	return add_global_scheduler(&gedf);
+}
+module_init(gedf_init);
+
+static void __exit gedf_exit(void)
+{
+	int cpu;
+
+	remove_global_scheduler(&gedf);
+
+	for_each_possible_cpu(cpu)
+		gq_free(gedf_queue(cpu));
+}
+module_exit(gedf_exit);
+
+MODULE_DESCRIPTION("Global EDF Scheduling Module for ChronOS");
+MODULE_AUTHOR("Ben Weinstein-Raun <b@w-r.me>");
+MODULE_LICENSE("GPL");
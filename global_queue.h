@@ -0,0 +1,381 @@
+/* chronos/global_queue.h
+ *
+ * Per-CPU ready queues with work stealing, for the global schedulers.
+ *
+ * A single global ready queue behind a single lock makes every
+ * scheduling decision on every CPU wait on every other. Instead, each
+ * CPU keeps its own queue behind its own lock:
+ *
+ *	- A job is released onto the queue of the CPU it was released on.
+ *	- Each CPU publishes its spare: the earliest deadline in its queue
+ *	  among the tasks it is not running. Reading another CPU's spare
+ *	  takes no lock.
+ *	- When a CPU schedules, it looks through the other CPUs' spares.
+ *	  If one is earlier than anything it has, it takes that task. It
+ *	  only trylocks the other CPU's queue, so a busy queue is passed
+ *	  over instead of waited on.
+ *	- Each CPU also publishes the deadline of the task it runs. When a
+ *	  job is released earlier than the latest of those, the CPU running
+ *	  the latest (or an idle one) is told to reschedule, and pulls it.
+ *	  So the m ready jobs with the earliest deadlines are the ones
+ *	  running, as soon as the CPUs told have rescheduled.
+ *
+ * A CPU only ever waits for its own queue's lock, which it shares with
+ * nobody but a thief and tasks leaving it. While a task moves, both
+ * queues are locked, so task->cpu always names a queue that either
+ * holds the task or is about to.
+ *
+ * Each queue is an array sorted by deadline that can start anywhere in
+ * its buffer, so taking the earliest task and releasing a job with a
+ * late deadline, the usual cases, move nothing; anything else moves the
+ * shorter side. That costs more than a heap for a task landing in the
+ * middle of a long queue, but it means the queue can be read in
+ * deadline order, which G-DASA's feasibility check needs.
+ *
+ * Queues that can't grow on release keep the extra tasks on an overflow
+ * list (SCHED_LIST4). Those are only seen by their own CPU and are moved
+ * into the array as soon as it can grow.
+ *
+ * Author(s)
+ *	- Ben Weinstein-Raun, bwr@vt.edu
+ *
+ * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
+ */
+
+#ifndef _CHRONOS_GLOBAL_QUEUE_H
+#define _CHRONOS_GLOBAL_QUEUE_H
+
+#include <linux/compiler.h>
+#include <linux/errno.h>
+#include <linux/list.h>
+#include <linux/percpu.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+#include <linux/types.h>
+#include <linux/time.h>
+#include <linux/chronos_types.h>
+#include <linux/chronos_sched.h>
+
+#define GQ_OVERFLOW_LIST	SCHED_LIST4
+
+struct gq_entry {
+	s64 deadline;
+	struct rt_info * task;
+};
+
+struct global_queue {
+	raw_spinlock_t lock;
+
+	// The queue is ready[first] to ready[first + nr - 1]
+	struct gq_entry * ready;
+	int first;
+	int nr;
+	int size;
+	struct list_head overflow;
+
+	// What this CPU decided to run last
+	struct rt_info * curr;
+
+	// Published with WRITE_ONCE() under lock, read without it
+	s64 spare;
+	// curr's deadline, or S64_MAX if idle
+	s64 running;
+} ____cacheline_aligned_in_smp;
+
+static inline void gq_init(struct global_queue * q)
+{
+	raw_spin_lock_init(&q->lock);
+	INIT_LIST_HEAD(&q->overflow);
+	q->spare = S64_MAX;
+	q->running = S64_MAX;
+}
+
+static inline void gq_free(struct global_queue * q)
+{
+	kfree(q->ready);
+	q->ready = NULL;
+	q->first = q->nr = q->size = 0;
+}
+
+static inline struct gq_entry * gq_entry(struct global_queue * q, int i)
+{
+	return &q->ready[q->first + i];
+}
+
+static inline bool gq_overflowed(struct rt_info * task)
+{
+	return !list_empty(&task->task_list[GQ_OVERFLOW_LIST]);
+}
+
+// Position of the first entry with a deadline after d
+static inline int gq_upper_bound(struct global_queue * q, s64 d)
+{
+	int lo = 0, hi = q->nr, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (gq_entry(q, mid)->deadline <= d)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+// Position of task in the queue, or -1
+static inline int gq_find(struct global_queue * q, struct rt_info * task)
+{
+	s64 d = timespec_to_ns(&task->deadline);
+	int i = gq_upper_bound(q, d);
+
+	while (--i >= 0 && gq_entry(q, i)->deadline == d)
+		if (gq_entry(q, i)->task == task)
+			return i;
+	return -1;
+}
+
+// Make room for one more entry
+static inline int gq_grow(struct global_queue * q)
+{
+	struct gq_entry * ready;
+	int size;
+
+	if (q->nr < q->size)
+		return 0;
+
+	size = q->size ? 2 * q->size : 64;
+	ready = krealloc(q->ready, size * sizeof(*ready), GFP_ATOMIC);
+	if (ready == NULL)
+		return -ENOMEM;
+	q->ready = ready;
+	q->size = size;
+	return 0;
+}
+
+// Insert in deadline order, after equal deadlines; there must be room
+static inline void gq_insert(struct global_queue * q, struct gq_entry e)
+{
+	int i = gq_upper_bound(q, e.deadline);
+	bool room_after = q->first + q->nr < q->size;
+
+	if (q->first > 0 && (!room_after || i < q->nr - i)) {
+		q->first--;
+		memmove(gq_entry(q, 0), gq_entry(q, 1), i * sizeof(e));
+	} else {
+		memmove(gq_entry(q, i + 1), gq_entry(q, i),
+			(q->nr - i) * sizeof(e));
+	}
+
+	*gq_entry(q, i) = e;
+	q->nr++;
+}
+
+static inline struct gq_entry gq_remove(struct global_queue * q, int i)
+{
+	struct gq_entry e = *gq_entry(q, i);
+
+	if (i < q->nr - 1 - i) {
+		memmove(gq_entry(q, 1), gq_entry(q, 0), i * sizeof(e));
+		q->first++;
+	} else {
+		memmove(gq_entry(q, i), gq_entry(q, i + 1),
+			(q->nr - 1 - i) * sizeof(e));
+	}
+
+	if (--q->nr == 0)
+		q->first = 0;
+	return e;
+}
+
+// Position of the earliest task other than curr, or -1
+static inline int gq_spare_index(struct global_queue * q)
+{
+	if (q->nr > 0 && gq_entry(q, 0)->task != q->curr)
+		return 0;
+	return q->nr > 1 ? 1 : -1;
+}
+
+static inline void gq_publish(struct global_queue * q)
+{
+	int i = gq_spare_index(q);
+
+	WRITE_ONCE(q->spare, i < 0 ? S64_MAX : gq_entry(q, i)->deadline);
+}
+
+// Add a released task; q must be locked
+static inline void gq_enqueue(struct global_queue * q, struct rt_info * task)
+{
+	struct gq_entry e = { timespec_to_ns(&task->deadline), task };
+
+	if (gq_grow(q)) {
+		list_add_tail(&task->task_list[GQ_OVERFLOW_LIST], &q->overflow);
+		return;
+	}
+
+	gq_insert(q, e);
+	gq_publish(q);
+}
+
+// Remove a task that is leaving the ready queue; q must be locked
+static inline void gq_dequeue(struct global_queue * q, struct rt_info * task)
+{
+	int i;
+
+	if (q->curr == task) {
+		q->curr = NULL;
+		WRITE_ONCE(q->running, S64_MAX);
+	}
+
+	if (gq_overflowed(task))
+		list_del_init(&task->task_list[GQ_OVERFLOW_LIST]);
+	else if ((i = gq_find(q, task)) >= 0)
+		gq_remove(q, i);
+
+	gq_publish(q);
+}
+
+// Move overflow tasks into the queue while it can grow; q must be locked
+static inline void gq_drain_overflow(struct global_queue * q)
+{
+	struct rt_info * task;
+
+	while (!list_empty(&q->overflow) && !gq_grow(q)) {
+		task = list_first_entry(&q->overflow, struct rt_info,
+					task_list[GQ_OVERFLOW_LIST]);
+		list_del_init(&task->task_list[GQ_OVERFLOW_LIST]);
+		gq_enqueue(q, task);
+	}
+}
+
+// The earliest deadline task on q, including any overflow
+static inline struct rt_info * gq_first(struct global_queue * q)
+{
+	struct rt_info * best = q->nr ? gq_entry(q, 0)->task : NULL;
+	struct rt_info * it;
+
+	list_for_each_entry(it, &q->overflow, task_list[GQ_OVERFLOW_LIST])
+		if (best == NULL || earlier_deadline(&it->deadline, &best->deadline))
+			best = it;
+	return best;
+}
+
+// Record what this CPU is about to run; q must be locked
+static inline void gq_run(struct global_queue * q, struct rt_info * task)
+{
+	q->curr = task;
+	WRITE_ONCE(q->running, task ? timespec_to_ns(&task->deadline) : S64_MAX);
+	gq_publish(q);
+}
+
+/*
+ * A job with deadline d was just released: have the CPU running the
+ * latest deadline after d, idle ones first, reschedule, so that it pulls
+ * the job. queue() maps a CPU to its queue. Lock-free, like
+ * gq_find_victim(); call with no queue locked.
+ */
+static inline void gq_preempt(struct global_queue * (*queue)(int cpu), s64 d)
+{
+	s64 running, latest = d;
+	int cpu, target = -1;
+
+	for_each_online_cpu(cpu) {
+		running = READ_ONCE(queue(cpu)->running);
+		if (running > latest) {
+			latest = running;
+			target = cpu;
+		}
+		if (latest == S64_MAX)
+			break;
+	}
+
+	if (target >= 0)
+		resched_cpu(target);
+}
+
+/*
+ * The CPU (other than self) with the earliest spare before limit, or
+ * NULL. queue() maps a CPU to its queue. Lock-free: the answer may be
+ * stale by the time the caller acts on it.
+ */
+static inline struct global_queue *
+gq_find_victim(struct global_queue * (*queue)(int cpu), int self, s64 limit)
+{
+	struct global_queue * victim = NULL;
+	s64 spare;
+	int cpu;
+
+	for_each_online_cpu(cpu) {
+		if (cpu == self)
+			continue;
+		spare = READ_ONCE(queue(cpu)->spare);
+		if (spare < limit) {
+			limit = spare;
+			victim = queue(cpu);
+		}
+	}
+	return victim;
+}
+
+/*
+ * Take victim's earliest spare task onto q, the queue of CPU self, if it
+ * is still earlier than limit. q must be locked; victim is only
+ * trylocked. Returns the task taken, or NULL.
+ */
+static inline struct rt_info * gq_steal(struct global_queue * q, int self,
+					struct global_queue * victim, s64 limit)
+{
+	struct gq_entry e;
+	int i;
+
+	if (gq_grow(q) || !raw_spin_trylock(&victim->lock))
+		return NULL;
+
+	i = gq_spare_index(victim);
+	if (i < 0 || gq_entry(victim, i)->deadline >= limit) {
+		raw_spin_unlock(&victim->lock);
+		return NULL;
+	}
+
+	e = gq_remove(victim, i);
+	gq_publish(victim);
+	WRITE_ONCE(e.task->cpu, self);
+	raw_spin_unlock(&victim->lock);
+
+	gq_insert(q, e);
+	gq_publish(q);
+	return e.task;
+}
+
+/*
+ * Steal from whichever CPU has the earliest spare task, if it is earlier
+ * than anything on q. q, the queue of CPU self, must be locked.
+ */
+static inline struct rt_info * gq_balance(struct global_queue * q, int self,
+					  struct global_queue * (*queue)(int cpu))
+{
+	struct global_queue * victim;
+	s64 limit = q->nr ? gq_entry(q, 0)->deadline : S64_MAX;
+
+	victim = gq_find_victim(queue, self, limit);
+	return victim ? gq_steal(q, self, victim, limit) : NULL;
+}
+
+// Lock and return the queue task is on
+static inline struct global_queue *
+gq_lock_task(struct global_queue * (*queue)(int cpu), struct rt_info * task)
+{
+	struct global_queue * q;
+	int cpu;
+
+	for (;;) {
+		cpu = READ_ONCE(task->cpu);
+		q = queue(cpu);
+		raw_spin_lock(&q->lock);
+		if (READ_ONCE(task->cpu) == cpu)
+			return q;
+		raw_spin_unlock(&q->lock);
+	}
+}
+
+#endif
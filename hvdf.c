@@ -1,6 +1,6 @@
-/* chronos/dasa-nd.c
+/* chronos/hvdf.c
  *
- * DASA-ND Single-Core Scheduler Module for ChronOS
+ * HVDF Single-Core Scheduler Module for ChronOS
  *
  * Author(s)
  *	- Matthew Dellinger, mdelling@vt.edu
@@ -12,106 +12,365 @@
 #include <linux/module.h>
 #include <linux/chronos_types.h>
 #include <linux/chronos_sched.h>
+#include <linux/errno.h>
 #include <linux/list.h>
+#include <linux/percpu.h>
+#include <linux/slab.h>
 
-struct rt_info* sched_dasa_nd(struct list_head *head, int flags)
+#include "ivd_cache.h"
+#include "sched_trace.h"
+
+/*
+ * Highest Value Density First: run the ready task with the lowest inverse
+ * value density. Each CPU keeps its ready tasks in a min-heap on IVD,
+ * maintained as tasks are released and complete.
+ *
+ * A task's IVD only changes when its remaining time or its utility does.
+ * Utility is set per job, at release, and remaining time only shrinks
+ * while the task runs, so the one key that can have gone stale since the
+ * last decision is that of the task we picked then. Each decision
+ * refreshes that task and the top of the heap, instead of recomputing
+ * every task's density, and costs O(log n).
+ *
+ * With SCHED_FLAG_HUA, a task that has missed its deadline is aborted and
+ * run at once, wherever it is in the heap. A second heap, of positions in
+ * the first ordered by deadline, keeps the earliest deadline at hand: if
+ * that one hasn't passed, none has, and if it has, it goes first.
+ */
+struct hvdf_entry {
+	long ivd;
+	s64 deadline;
+	struct rt_info * task;
+	// Position in by_deadline
+	int dl;
+};
+
+struct hvdf_queue {
+	struct hvdf_entry * heap;
+	// Positions in heap, as a min-heap on deadline
+	int * by_deadline;
+	int nr;
+	int size;
+	// Ready tasks that didn't fit because the heap couldn't grow. While
+	// there are any, schedule by scanning the ready list instead.
+	int missing;
+	// The task picked by the last decision, the one that has run since
+	struct rt_info * last;
+};
+
+static DEFINE_PER_CPU(struct hvdf_queue, hvdf_queues);
+
+// Higher density first, then earlier deadline
+static inline bool hvdf_before(struct hvdf_entry * a, struct hvdf_entry * b)
+{
+	return a->ivd < b->ivd || (a->ivd == b->ivd && a->deadline < b->deadline);
+}
+
+static inline void hvdf_set(struct hvdf_queue * q, int i, struct hvdf_entry e)
 {
-	const int DENSITY_LIST = SCHED_LIST1;
-	const int SCHEDULE_LIST = SCHED_LIST2;
-	
-	// ChronOS seems to want to do everything to an rt_info* rather
-	// than the direct list_heads, while list.h expects a dummy list
-	// node to act as the head.
-	struct rt_info density_list;
-	struct rt_info schedule;
+	q->heap[i] = e;
+	q->by_deadline[e.dl] = i;
+	e.task->heap_index = i;
+}
 
-	struct rt_info * it;
+static inline void hvdf_dl_set(struct hvdf_queue * q, int j, int i)
+{
+	q->by_deadline[j] = i;
+	q->heap[i].dl = j;
+}
 
-	struct timespec t1;
+static inline bool hvdf_dl_before(struct hvdf_queue * q, int i, int k)
+{
+	return q->heap[i].deadline < q->heap[k].deadline;
+}
 
-	INIT_LIST_HEAD(&(density_list.task_list[DENSITY_LIST]));
-	INIT_LIST_HEAD(&(schedule.task_list[SCHEDULE_LIST]));
+static void hvdf_dl_sift_up(struct hvdf_queue * q, int j)
+{
+	int i = q->by_deadline[j];
 
-	// for each task in ready tasks,
-	list_for_each_entry(it, head, task_list[LOCAL_LIST]) {
-		// if a task is aborted, return it
-		if (check_task_aborted(it)) return it;
+	while (j > 0 && hvdf_dl_before(q, i, q->by_deadline[(j - 1) / 2])) {
+		hvdf_dl_set(q, j, q->by_deadline[(j - 1) / 2]);
+		j = (j - 1) / 2;
+	}
+	hvdf_dl_set(q, j, i);
+}
 
-		t1 = current_kernel_time();
+static void hvdf_dl_sift_down(struct hvdf_queue * q, int j)
+{
+	int i = q->by_deadline[j], child;
 
-		// if a task has blown its deadline,
-		if (earlier_deadline(&(it->deadline), &t1)) {
-			// abort it and return it
-			abort_thread(it);
-			return it;
+	while ((child = 2 * j + 1) < q->nr) {
+		if (child + 1 < q->nr &&
+		    hvdf_dl_before(q, q->by_deadline[child + 1],
+				   q->by_deadline[child]))
+			child++;
+		if (!hvdf_dl_before(q, q->by_deadline[child], i))
+			break;
+		hvdf_dl_set(q, j, q->by_deadline[child]);
+		j = child;
+	}
+	hvdf_dl_set(q, j, i);
+}
+
+static void hvdf_sift_up(struct hvdf_queue * q, int i)
+{
+	struct hvdf_entry e = q->heap[i];
+
+	while (i > 0 && hvdf_before(&e, &q->heap[(i - 1) / 2])) {
+		hvdf_set(q, i, q->heap[(i - 1) / 2]);
+		i = (i - 1) / 2;
+	}
+	hvdf_set(q, i, e);
+}
+
+static void hvdf_sift_down(struct hvdf_queue * q, int i)
+{
+	struct hvdf_entry e = q->heap[i];
+	int child;
+
+	while ((child = 2 * i + 1) < q->nr) {
+		if (child + 1 < q->nr &&
+		    hvdf_before(&q->heap[child + 1], &q->heap[child]))
+			child++;
+		if (!hvdf_before(&q->heap[child], &e))
+			break;
+		hvdf_set(q, i, q->heap[child]);
+		i = child;
+	}
+	hvdf_set(q, i, e);
+}
+
+static inline bool hvdf_queued(struct hvdf_queue * q, struct rt_info * task)
+{
+	int i = task->heap_index;
+
+	return i >= 0 && i < q->nr && q->heap[i].task == task;
+}
+
+// Aborted tasks go to the top, so they get to run their abort handlers
+static inline long hvdf_key(struct rt_info * task, int flags)
+{
+	long ivd = cached_livd(task, 0, flags);
+
+	return check_task_aborted(task) ? LONG_MIN : ivd;
+}
+
+// Bring the key of the task at i up to date and move it to its new
+// place. Returns true if the key changed.
+static bool hvdf_refresh(struct hvdf_queue * q, int i, int flags)
+{
+	struct rt_info * task = q->heap[i].task;
+	long ivd = hvdf_key(task, flags);
+
+	if (ivd == q->heap[i].ivd)
+		return false;
+
+	q->heap[i].ivd = ivd;
+
+	hvdf_sift_up(q, i);
+	hvdf_sift_down(q, task->heap_index);
+	return true;
+}
+
+// Make room for nr more tasks
+static int hvdf_reserve(struct hvdf_queue * q, int nr)
+{
+	struct hvdf_entry * heap;
+	int * by_deadline;
+	int size = q->size ? q->size : 64;
+
+	if (q->nr + nr <= q->size)
+		return 0;
+
+	while (size < q->nr + nr)
+		size *= 2;
+	heap = krealloc(q->heap, size * sizeof(*heap), GFP_ATOMIC);
+	if (heap == NULL)
+		return -ENOMEM;
+	q->heap = heap;
+	by_deadline = krealloc(q->by_deadline, size * sizeof(*by_deadline),
+			       GFP_ATOMIC);
+	if (by_deadline == NULL)
+		return -ENOMEM;
+	q->by_deadline = by_deadline;
+	q->size = size;
+	return 0;
+}
+
+static inline void hvdf_append(struct hvdf_queue * q, struct rt_info * task,
+			       int flags)
+{
+	q->heap[q->nr].task = task;
+	q->heap[q->nr].deadline = timespec_to_ns(&task->deadline);
+	q->heap[q->nr].ivd = hvdf_key(task, flags);
+	hvdf_dl_set(q, q->nr, q->nr);
+	task->heap_index = q->nr++;
+}
+
+void enqueue_hvdf(struct rt_info * task, int flags)
+{
+	struct hvdf_queue * q = &per_cpu(hvdf_queues, task->cpu);
+
+	if (hvdf_reserve(q, 1)) {
+		q->missing++;
+		task->heap_index = -1;
+		return;
+	}
+
+	hvdf_append(q, task, flags);
+	hvdf_dl_sift_up(q, q->nr - 1);
+	hvdf_sift_up(q, q->nr - 1);
+}
+
+// As in EDF: sift each job released together up, or rebuild the heap
+// once there are as many of them as there were tasks already
+void enqueue_batch_hvdf(struct rt_info ** tasks, int nr, int flags)
+{
+	struct hvdf_queue * q = &per_cpu(hvdf_queues, tasks[0]->cpu);
+	int old = q->nr, i;
+
+	if (hvdf_reserve(q, nr)) {
+		for (i = 0; i < nr; i++)
+			enqueue_hvdf(tasks[i], flags);
+		return;
+	}
+
+	for (i = 0; i < nr; i++)
+		hvdf_append(q, tasks[i], flags);
+
+	if (nr < old) {
+		for (i = old; i < q->nr; i++) {
+			hvdf_dl_sift_up(q, i);
+			hvdf_sift_up(q, i);
+		}
+	} else {
+		for (i = q->nr / 2 - 1; i >= 0; i--) {
+			hvdf_dl_sift_down(q, i);
+			hvdf_sift_down(q, i);
 		}
+	}
+}
 
-		// The following call required adding an EXPORT_SYMBOL()
-		// even though it was non-static and had public prototypes.
-		// This probably won't work in stock ChronOS.
+void dequeue_hvdf(struct rt_info * task, int flags)
+{
+	struct hvdf_queue * q = &per_cpu(hvdf_queues, task->cpu);
+	struct rt_info * moved;
+	int i = task->heap_index, j, last;
 
-		// compute task's remaining time
-		update_left(it);
+	if (q->last == task)
+		q->last = NULL;
 
-		// compute task's IVD
-		livd(it, 0, flags);
+	if (i < 0) {
+		q->missing--;
+		return;
+	}
+	if (!hvdf_queued(q, task))
+		return;
 
-		
-		// initialize list heads
-		initialize_lists(it);
+	// Take it out of by_deadline first, filling the hole with the last
+	// position there, while the heap positions still hold
+	j = q->heap[i].dl;
+	if (j != q->nr - 1) {
+		last = q->by_deadline[q->nr - 1];
+		hvdf_dl_set(q, j, last);
+		q->nr--;
+		hvdf_dl_sift_up(q, j);
+		hvdf_dl_sift_down(q, q->heap[last].dl);
+		q->nr++;
+	}
 
-		// add it to density list
-		//list_add_after(&density_list, it, DENSITY_LIST);
-		insert_on_list(it, &density_list, DENSITY_LIST, SORT_KEY_LVD, 1);
+	// Fill the hole with the last entry and let it find its place
+	if (i != --q->nr) {
+		moved = q->heap[q->nr].task;
+		hvdf_set(q, i, q->heap[q->nr]);
+		hvdf_sift_up(q, i);
+		hvdf_sift_down(q, moved->heap_index);
 	}
+}
 
-	// quicksort tasks by IVD
-	//quicksort(&density_list,
-			//DENSITY_LIST, 
-			//SORT_KEY_LVD, 1);
+// Fallback for when the heap is out of sync with the ready list
+static struct rt_info * hvdf_scan(struct list_head *head, int flags)
+{
+	struct rt_info * it, * best = NULL;
 
-	// for each task, by value density
-	list_for_each_entry(it, &(density_list.task_list[DENSITY_LIST]), task_list[DENSITY_LIST]) {
-		// add it to the schedule, sorted by deadline
-		insert_on_list(it, &schedule, SCHEDULE_LIST, SORT_KEY_DEADLINE, 1);
+	list_for_each_entry(it, head, task_list[LOCAL_LIST]) {
+		if (check_task_failure(it, flags))
+			return it;
 
-		// check to see if schedule is feasible and, if not, remove it.
-		// I think this one also required an EXPORT_SYMBOL.
-		//if (!list_is_feasible(&schedule, SCHEDULE_LIST))
-			//list_remove(it, SCHEDULE_LIST);
+		cached_livd(it, 0, flags);
+		if (best == NULL || it->local_ivd < best->local_ivd ||
+		    (it->local_ivd == best->local_ivd &&
+		     earlier_deadline(&it->deadline, &best->deadline)))
+			best = it;
 	}
 
-	// return first task in schedule
-	// (or if something went wrong just return the first thing in the queue)
-	//if (!list_empty(&(schedule.task_list[SCHEDULE_LIST])))
-		return list_first_entry(&(schedule.task_list[SCHEDULE_LIST]), struct rt_info, task_list[SCHEDULE_LIST]);
-	//else
-		//return list_first_entry(head, struct rt_info, task_list[LOCAL_LIST]);
+	return best;
+}
+
+static struct rt_info * __sched_hvdf(struct list_head *head, int flags)
+{
+	struct hvdf_queue * q = this_cpu_ptr(&hvdf_queues);
+	struct rt_info * best;
+
+	if (q->nr == 0 || q->missing)
+		return q->last = hvdf_scan(head, flags);
 
+	if (q->last && hvdf_queued(q, q->last))
+		hvdf_refresh(q, q->last->heap_index, flags);
+
+	// Anything else that changed behind our back is caught once it
+	// reaches the top
+	while (hvdf_refresh(q, 0, flags))
+		;
+
+	// A task that has blown its deadline is aborted and runs first; if
+	// the earliest deadline hasn't passed, none has
+	if (flags & SCHED_FLAG_HUA) {
+		best = q->heap[q->by_deadline[0]].task;
+		if (check_task_failure(best, flags))
+			return q->last = best;
+	}
+
+	// Aborted tasks are at the top once their keys are refreshed
+	return q->last = q->heap[0].task;
 }
 
-struct rt_sched_local dasa_nd = {
-	.base.name = "DASA_ND",
-	.base.id = SCHED_RT_DASA_ND,
+struct rt_info * sched_hvdf(struct list_head *head, int flags)
+{
+	return sched_trace_decision(SCHED_RT_HVDF, head, flags, __sched_hvdf);
+}
+
+struct rt_sched_local hvdf = {
+	.base.name = "HVDF",
+	.base.id = SCHED_RT_HVDF,
 	.flags = 0,
-	.schedule = sched_dasa_nd,
+	.schedule = sched_hvdf,
+	.enqueue = enqueue_hvdf,
+	.dequeue = dequeue_hvdf,
+	.enqueue_batch = enqueue_batch_hvdf,
 	.base.sort_key = SORT_KEY_PERIOD,
-	.base.list = LIST_HEAD_INIT(dasa_nd.base.list)
+	.base.list = LIST_HEAD_INIT(hvdf.base.list)
 };
 
-static int __init dasa_nd_init(void)
+static int __init hvdf_init(void)
 {
-	return add_local_scheduler(&dasa_nd);
+	return add_local_scheduler(&hvdf);
 }
-module_init(dasa_nd_init);
+module_init(hvdf_init);
 
-static void __exit dasa_nd_exit(void)
+static void __exit hvdf_exit(void)
 {
-	remove_local_scheduler(&dasa_nd);
+	int cpu;
+
+	remove_local_scheduler(&hvdf);
+
+	for_each_possible_cpu(cpu) {
+		kfree(per_cpu(hvdf_queues, cpu).heap);
+		kfree(per_cpu(hvdf_queues, cpu).by_deadline);
+	}
 }
-module_exit(dasa_nd_exit);
+module_exit(hvdf_exit);
 
-MODULE_DESCRIPTION("DASA-ND Single-Core Scheduling Module for ChronOS");
+MODULE_DESCRIPTION("HVDF Single-Core Scheduling Module for ChronOS");
 MODULE_AUTHOR("Ben Weinstein-Raun <b@w-r.me>");
 MODULE_LICENSE("GPL");
-
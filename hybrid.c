@@ -0,0 +1,357 @@
+/* chronos/hybrid.c
+ *
+ * Hybrid EDF/DASA-ND Single-Core Scheduler Module for ChronOS
+ *
+ * Author(s)
+ *	- Ben Weinstein-Raun, bwr@vt.edu
+ *
+ * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
+ */
+
+#include <linux/module.h>
+#include <linux/chronos_types.h>
+#include <linux/chronos_sched.h>
+#include <linux/errno.h>
+#include <linux/list.h>
+#include <linux/percpu.h>
+#include <linux/slab.h>
+
+#include "dasa_nd.h"
+#include "decision_cache.h"
+#include "ivd_cache.h"
+#include "sched_budget.h"
+#include "sched_overhead.h"
+#include "sched_trace.h"
+#include "sched_variant.h"
+
+/*
+ * While every ready task can still meet its deadline, DASA-ND accepts
+ * them all and runs the earliest deadline, which is what EDF would do for
+ * a fraction of the cost. This scheduler runs EDF for as long as that
+ * holds and DASA-ND only under overload.
+ *
+ * Each CPU keeps its ready tasks in a slack tree (see slack_tree.h), in
+ * deadline order with their remaining times, maintained as tasks are
+ * released and complete. The tree's root says whether running them all in
+ * deadline order from now meets every deadline, and the first node is the
+ * EDF pick. Remaining time only shrinks while a task runs, so, as in
+ * HVDF, the one node that can have gone stale since the last decision is
+ * that of the task picked then, and each decision refreshes it. A
+ * decision under EDF costs O(log n).
+ *
+ * The CPU counts as overloaded from the first decision that finds the
+ * tree infeasible until one finds it feasible with slack to spare, at
+ * least 1/2^HYBRID_HEADROOM_SHIFT of the demand. Without that margin, a
+ * CPU running right at the edge would switch on every release. With the
+ * overhead charge of sched_overhead.h, the slack has to cover the charge
+ * of every ready task as well, which is at least what DASA-ND's own
+ * feasibility test charges any prefix of the schedule.
+ *
+ * Under overload, the decision is DASA-ND's, with its decision cache and
+ * time budget. DASA-ND on a feasible set is EDF, so the decisions are
+ * the same as DASA-ND's throughout; only their cost differs.
+ */
+#define HYBRID_HEADROOM_SHIFT	3
+
+struct hybrid_queue {
+	// Every ready task, in deadline order and, among equal deadlines,
+	// in the order they were released, as on the ready list.
+	// nodes[task->heap_index] is task's node; nodes only grows, and the
+	// tree is rebuilt when it moves.
+	struct slack_tree demand;
+	struct slack_node * nodes;
+	unsigned long seq;
+	int nr;
+	int size;
+	// Ready tasks that didn't fit because nodes couldn't grow. While
+	// there are any, every decision is DASA-ND's.
+	int missing;
+	// The task picked by the last decision, the one that has run since
+	struct rt_info * last;
+	bool overload;
+};
+
+static DEFINE_PER_CPU(struct hybrid_queue, hybrid_queues);
+static DEFINE_PER_CPU(struct rq_snapshot, snapshots);
+static DEFINE_PER_CPU(struct slack_pool, schedule_nodes);
+static DEFINE_PER_CPU(struct decision_cache, decisions);
+
+static inline bool hybrid_queued(struct hybrid_queue * q, struct rt_info * task)
+{
+	int i = task->heap_index;
+
+	return i >= 0 && i < q->nr && q->nodes[i].task == task;
+}
+
+// Make room for nr more tasks
+static int hybrid_reserve(struct hybrid_queue * q, int nr, gfp_t gfp)
+{
+	struct slack_node * nodes;
+	int size = q->size ? q->size : RQ_SNAPSHOT_PREALLOC, i;
+
+	if (q->nr + nr <= q->size)
+		return 0;
+
+	while (size < q->nr + nr)
+		size *= 2;
+	nodes = krealloc(q->nodes, size * sizeof(*nodes), gfp);
+	if (nodes == NULL)
+		return -ENOMEM;
+	q->nodes = nodes;
+	q->size = size;
+
+	// Put every node back where it was, at its new address
+	slack_tree_init(&q->demand);
+	for (i = 0; i < q->nr; i++)
+		slack_reinsert(&q->demand, &q->nodes[i]);
+	return 0;
+}
+
+// Bring the remaining time of task's node up to date
+static void hybrid_refresh(struct hybrid_queue * q, struct rt_info * task)
+{
+	struct slack_node * node = &q->nodes[task->heap_index];
+	s64 left = timespec_to_ns(&task->left);
+
+	if (left == node->exec)
+		return;
+
+	slack_erase(&q->demand, node);
+	node->exec = left;
+	slack_reinsert(&q->demand, node);
+}
+
+static inline void hybrid_insert(struct hybrid_queue * q, struct rt_info * task)
+{
+	struct slack_node * node = &q->nodes[q->nr];
+
+	task->heap_index = q->nr++;
+	slack_node_init(node, task, &task->deadline);
+	node->seq = q->seq++;
+	slack_reinsert(&q->demand, node);
+}
+
+void enqueue_hybrid(struct rt_info * task, int flags)
+{
+	struct hybrid_queue * q = &per_cpu(hybrid_queues, task->cpu);
+
+	decision_cache_invalidate(&per_cpu(decisions, task->cpu));
+
+	if (hybrid_reserve(q, 1, GFP_ATOMIC)) {
+		q->missing++;
+		task->heap_index = -1;
+		return;
+	}
+
+	hybrid_insert(q, task);
+}
+
+// Grow nodes (rebuilding the tree) and drop the cached decision at most
+// once for the whole batch
+void enqueue_batch_hybrid(struct rt_info ** tasks, int nr, int flags)
+{
+	struct hybrid_queue * q = &per_cpu(hybrid_queues, tasks[0]->cpu);
+	int i;
+
+	if (hybrid_reserve(q, nr, GFP_ATOMIC)) {
+		for (i = 0; i < nr; i++)
+			enqueue_hybrid(tasks[i], flags);
+		return;
+	}
+
+	decision_cache_invalidate(&per_cpu(decisions, tasks[0]->cpu));
+	for (i = 0; i < nr; i++)
+		hybrid_insert(q, tasks[i]);
+}
+
+void dequeue_hybrid(struct rt_info * task, int flags)
+{
+	struct hybrid_queue * q = &per_cpu(hybrid_queues, task->cpu);
+	struct slack_node * moved;
+	int i = task->heap_index;
+
+	decision_cache_invalidate(&per_cpu(decisions, task->cpu));
+
+	if (q->last == task)
+		q->last = NULL;
+
+	if (i < 0) {
+		q->missing--;
+		return;
+	}
+	if (!hybrid_queued(q, task))
+		return;
+
+	slack_erase(&q->demand, &q->nodes[i]);
+
+	// Fill the hole with the last node, keeping its place in the tree
+	if (i != --q->nr) {
+		moved = &q->nodes[q->nr];
+		slack_erase(&q->demand, moved);
+		q->nodes[i] = *moved;
+		moved->task = NULL;
+		moved = &q->nodes[i];
+		moved->task->heap_index = i;
+		slack_reinsert(&q->demand, moved);
+	} else {
+		q->nodes[i].task = NULL;
+	}
+}
+
+static void hybrid_lock_event(struct rt_info * task, struct mutex_head * m,
+			      int flags)
+{
+	decision_cache_invalidate(&per_cpu(decisions, task->cpu));
+}
+
+// Whether this decision is one for DASA-ND, updating the CPU's mode
+static bool hybrid_overloaded(struct hybrid_queue * q, s64 now)
+{
+	struct decision_cache * dc = this_cpu_ptr(&decisions);
+	s64 slack = slack_latest_start(&q->demand) - now -
+		    q->nr * sched_overhead_charge();
+	bool overload = q->overload;
+
+	if (q->missing)
+		return true;
+
+	if (!overload)
+		overload = slack < 0;
+	else
+		overload = slack < q->demand.root->sum >> HYBRID_HEADROOM_SHIFT;
+
+	// A decision cached under the other mode may not stand in this one
+	if (overload != q->overload)
+		decision_cache_invalidate(dc);
+	q->overload = overload;
+	return overload;
+}
+
+static __always_inline struct rt_info * hybrid_dasa_nd(struct list_head *head,
+						       int flags, s64 now,
+						       const int variant)
+{
+	struct rq_snapshot * snap = this_cpu_ptr(&snapshots);
+	struct decision_cache * dc = this_cpu_ptr(&decisions);
+	struct rt_info * it;
+	struct sched_budget budget;
+	s64 horizon;
+
+	// Nothing has happened that could change the last decision
+	it = decision_cache_get(dc, now, flags);
+	if (it != NULL)
+		return it;
+
+	sched_budget_start(&budget);
+	rq_snapshot_reset(snap);
+
+	list_for_each_entry(it, head, task_list[LOCAL_LIST]) {
+		// if a task is aborted, return it
+		if (sched_task_failed(it, now, variant)) return it;
+
+		cached_livd(it, 0, flags);
+
+		if (rq_snapshot_add(snap, it))
+			return local_task(head->next);
+	}
+
+	it = dasa_nd_decide(snap, this_cpu_ptr(&schedule_nodes), now, &budget,
+			    &horizon);
+	decision_cache_set(dc, it, now, horizon, flags);
+	return it;
+}
+
+static __always_inline struct rt_info * __sched_hybrid(struct list_head *head,
+						       int flags, const int variant)
+{
+	struct hybrid_queue * q = this_cpu_ptr(&hybrid_queues);
+	struct rt_info * best;
+
+	struct timespec now_ts = CURRENT_TIME;
+	s64 now = timespec_to_ns(&now_ts);
+
+	if (q->last && hybrid_queued(q, q->last))
+		hybrid_refresh(q, q->last);
+
+	if (q->nr == 0 && !q->missing)
+		return q->last = NULL;
+
+	if (hybrid_overloaded(q, now))
+		return q->last = hybrid_dasa_nd(head, flags, now, variant);
+
+	// Every deadline can still be met, so none has been missed; this
+	// only catches a task aborted while it was not at the front
+	best = slack_first(&q->demand)->task;
+	sched_task_failed(best, now, variant);
+
+	return q->last = best;
+}
+
+DEFINE_SCHED_VARIANTS(hybrid_variants, __sched_hybrid);
+
+struct rt_info * sched_hybrid(struct list_head *head, int flags)
+{
+	return sched_trace_decision(SCHED_RT_HYBRID, head, flags,
+				    sched_variant(hybrid_variants, flags));
+}
+
+struct rt_sched_local hybrid = {
+	.base.name = "HYBRID",
+	.base.id = SCHED_RT_HYBRID,
+	.flags = 0,
+	.schedule = sched_hybrid,
+	.enqueue = enqueue_hybrid,
+	.dequeue = dequeue_hybrid,
+	.enqueue_batch = enqueue_batch_hybrid,
+	.lock = hybrid_lock_event,
+	.unlock = hybrid_lock_event,
+	.block = hybrid_lock_event,
+	.base.sort_key = SORT_KEY_DEADLINE,
+	.base.list = LIST_HEAD_INIT(hybrid.base.list)
+};
+
+static int __init hybrid_init(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		slack_tree_init(&per_cpu(hybrid_queues, cpu).demand);
+		decision_cache_init(&per_cpu(decisions, cpu));
+		if (hybrid_reserve(&per_cpu(hybrid_queues, cpu),
+				   RQ_SNAPSHOT_PREALLOC, GFP_KERNEL) ||
+		    rq_snapshot_grow(&per_cpu(snapshots, cpu)) ||
+		    !slack_pool_get(&per_cpu(schedule_nodes, cpu),
+				    RQ_SNAPSHOT_PREALLOC))
+			goto nomem;
+	}
+
+	return add_local_scheduler(&hybrid);
+
+nomem:
+	for_each_possible_cpu(cpu) {
+		kfree(per_cpu(hybrid_queues, cpu).nodes);
+		rq_snapshot_free(&per_cpu(snapshots, cpu));
+		slack_pool_free(&per_cpu(schedule_nodes, cpu));
+	}
+	return -ENOMEM;
+}
+module_init(hybrid_init);
+
+static void __exit hybrid_exit(void)
+{
+	int cpu;
+
+	remove_local_scheduler(&hybrid);
+
+	for_each_possible_cpu(cpu) {
+		kfree(per_cpu(hybrid_queues, cpu).nodes);
+		rq_snapshot_free(&per_cpu(snapshots, cpu));
+		slack_pool_free(&per_cpu(schedule_nodes, cpu));
+		decision_cache_exit(&per_cpu(decisions, cpu));
+	}
+}
+module_exit(hybrid_exit);
+
+MODULE_DESCRIPTION("Hybrid EDF/DASA-ND Single-Core Scheduling Module for ChronOS");
+MODULE_AUTHOR("Ben Weinstein-Raun <b@w-r.me>");
+MODULE_LICENSE("GPL");
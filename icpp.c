@@ -12,86 +12,178 @@
 #include <linux/module.h>
 #include <linux/chronos_types.h>
 #include <linux/chronos_sched.h>
+#include <linux/errno.h>
 #include <linux/list.h>
-#include <linux/list_sort.h>
+#include <linux/percpu.h>
+#include <linux/slab.h>
+
+#include "prio_queue.h"
+#include "sched_trace.h"
+
+/*
+ * Immediate Ceiling Priority Protocol. Tasks run at rate monotonic
+ * priority (their period in us; smaller is higher), except that a task
+ * holding a lock runs at least at that lock's ceiling: the highest
+ * priority of any task that uses it. Since the holder then outranks
+ * everything else that could want the lock, nothing ever blocks on a
+ * lock on this CPU, and a task is blocked at most once, for at most one
+ * critical section of a lower priority task.
+ *
+ * Ceilings are set up front: the core calls register_lock for every
+ * task and lock it uses before the task first runs (see
+ * chronos_rq_register_lock() in the userspace core). A lock taken by a
+ * task that wasn't registered for it still has its ceiling raised then,
+ * as a fallback, but that can't undo blocking that already happened.
+ *
+ * Priorities change on lock and unlock, and each CPU keeps its ready
+ * tasks in a priority bitmap queue (prio_queue.h), so a decision takes
+ * O(1) no matter how many tasks are ready. Critical sections are assumed
+ * to nest properly: unlocking restores the priority from before the
+ * matching lock.
+ */
+
+// A chain of owners longer than this is a deadlock, which can't happen
+// once every lock's ceiling is known
+#define ICPP_MAX_CHAIN	16
 
-static const int DYNAMIC_SCHEDULE = SCHED_LIST1;
+// Too big for static per-CPU space; allocated at init
+static DEFINE_PER_CPU(struct prio_queue *, icpp_queues);
 
-int task_cmp_by_dynamic_priority(void * _, struct list_head * a, struct list_head * b) {
-	struct rt_info * a_task, * b_task;
+static inline unsigned long icpp_base_priority(struct rt_info * task)
+{
+	return timespec_to_long(&task->period);
+}
 
-	a_task = list_entry(a, struct rt_info, task_list[DYNAMIC_SCHEDULE]);
-	b_task = list_entry(b, struct rt_info, task_list[DYNAMIC_SCHEDULE]);
+// Raise m's ceiling to task's priority if need be
+static inline void icpp_raise_ceiling(struct mutex_head * m, struct rt_info * task)
+{
+	unsigned long prio = icpp_base_priority(task);
 
-	return ((signed long) b_task->dynamic_priority) - ((signed long) a_task->dynamic_priority);
+	if (m->ceiling == 0 || prio < m->ceiling)
+		m->ceiling = prio;
 }
 
+// Declare that task uses m. If m is held, its owner moves up to the new
+// ceiling at once.
+void register_icpp(struct rt_info * task, struct mutex_head * m, int flags)
+{
+	struct rt_info * owner = m->owner_t;
 
-struct rt_info* sched_icpp(struct list_head *head, int flags)
+	icpp_raise_ceiling(m, task);
+
+	if (owner != NULL && m->ceiling < owner->dynamic_priority)
+		pq_requeue(per_cpu(icpp_queues, owner->cpu), owner,
+			   m->ceiling, true);
+}
+
+void enqueue_icpp(struct rt_info * task, int flags)
 {
-	struct rt_info * it, * best;
+	// A task coming back from blocking keeps any ceiling it holds
+	if (task->locks_held == 0 || task->dynamic_priority == 0)
+		task->dynamic_priority = icpp_base_priority(task);
 
-	struct list_head dynamic_schedule;
+	pq_enqueue(per_cpu(icpp_queues, task->cpu), task, false);
+}
 
-	
-	unsigned long csstar;
+void dequeue_icpp(struct rt_info * task, int flags)
+{
+	pq_dequeue(per_cpu(icpp_queues, task->cpu), task);
+}
 
-	INIT_LIST_HEAD(&dynamic_schedule);
-	csstar = ULONG_MAX;
-	best = NULL;
+// Raise the new owner to m's ceiling. It keeps running ahead of any
+// task already at that priority.
+void lock_icpp(struct rt_info * task, struct mutex_head * m, int flags)
+{
+	struct prio_queue * q = per_cpu(icpp_queues, task->cpu);
 
-	list_for_each_entry(it, head, task_list[LOCAL_LIST]) {
-		if (it->dynamic_priority == 0) 
-			it->dynamic_priority = timespec_to_long(&it->period);
-		
-		// if (check_task_failure(it, flags)) return it;
+	icpp_raise_ceiling(m, task);
+	m->saved_priority = task->dynamic_priority;
 
-		if (it->dynamic_priority < csstar) {
-			if(it->locks_held > 0)
-				csstar = it->dynamic_priority;
+	if (m->ceiling < task->dynamic_priority)
+		pq_requeue(q, task, m->ceiling, true);
+}
 
-			printk("setting best with priority %lu\n", it->dynamic_priority);
-			best = it;
-		}
+void unlock_icpp(struct rt_info * task, struct mutex_head * m, int flags)
+{
+	struct prio_queue * q = per_cpu(icpp_queues, task->cpu);
+	unsigned long prio = task->locks_held ? m->saved_priority :
+					       icpp_base_priority(task);
 
-		// list_add(&(it->task_list[DYNAMIC_SCHEDULE]), &dynamic_schedule);
-	}
-	
-	if (best != NULL) {
-		return best;
-	}
+	if (prio != task->dynamic_priority)
+		pq_requeue(q, task, prio, true);
+}
 
-	// list_sort(NULL, &dynamic_schedule, task_cmp_by_dynamic_priority);
+static struct rt_info * __sched_icpp(struct list_head *head, int flags)
+{
+	struct prio_queue * q = __this_cpu_read(icpp_queues);
+	struct rt_info * best, * owner;
+	int i;
+
+	best = pq_first(q);
+	if (best == NULL)
+		return NULL;
+
+	// If it is blocked after all, a ceiling was too low; run whatever
+	// holds the lock instead
+	for (i = 0; i < ICPP_MAX_CHAIN && best->requested_resource != NULL; i++) {
+		owner = best->requested_resource->owner_t;
+		if (owner == NULL || owner == best || owner->cpu != best->cpu)
+			break;
+		best = owner;
+	}
 
-	//list_for_each_entry(it, &dynamic_schedule, task_list[DYNAMIC_SCHEDULE]) {
-		//if (it->requested_resource == NULL || it->dynamic_priority < csstar) {
-			//printk("returning a task due to dynamic priority\n");
-			//return it;
-		//}
-	//}
+	return best;
+}
 
-	printk("falling back to first item in schedule\n");
-	return local_task(head->next);
+struct rt_info * sched_icpp(struct list_head *head, int flags)
+{
+	return sched_trace_decision(SCHED_RT_ICPP, head, flags, __sched_icpp);
 }
 
-struct rt_sched_local icpp= {
+struct rt_sched_local icpp = {
 	.base.name = "ICPP",
 	.base.id = SCHED_RT_ICPP,
 	.flags = 0,
 	.schedule = sched_icpp,
-	.base.sort_key = SORT_KEY_PERIOD,
+	.enqueue = enqueue_icpp,
+	.dequeue = dequeue_icpp,
+	.register_lock = register_icpp,
+	.lock = lock_icpp,
+	.unlock = unlock_icpp,
+	.base.sort_key = SORT_KEY_NONE,
 	.base.list = LIST_HEAD_INIT(icpp.base.list)
 };
 
 static int __init icpp_init(void)
 {
+	struct prio_queue * q;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		q = kmalloc(sizeof(*q), GFP_KERNEL);
+		if (q == NULL)
+			goto fail;
+		pq_init(q);
+		per_cpu(icpp_queues, cpu) = q;
+	}
+
 	return add_local_scheduler(&icpp);
+
+fail:
+	for_each_possible_cpu(cpu)
+		kfree(per_cpu(icpp_queues, cpu));
+	return -ENOMEM;
 }
 module_init(icpp_init);
 
 static void __exit icpp_exit(void)
 {
+	int cpu;
+
 	remove_local_scheduler(&icpp);
+
+	for_each_possible_cpu(cpu)
+		kfree(per_cpu(icpp_queues, cpu));
 }
 module_exit(icpp_exit);
 
@@ -0,0 +1,59 @@
+/* chronos/ivd_cache.h
+ *
+ * Cached inverse value densities.
+ *
+ * livd() divides a task's remaining time by its utility, and with
+ * dependency inheritance walks its whole dependency chain to do so.
+ * Between two scheduling events almost none of that changes: only the
+ * task that ran has less time left. cached_livd() keeps what each task's
+ * local_ivd was computed from and only calls livd() again once that is
+ * out of date:
+ *
+ *	- on release, when the core clears IVD_CACHED for the new job,
+ *	- when the task has run, so its remaining time changed,
+ *	- when its utility has changed,
+ *	- and whenever it has a dependency chain to inherit from. Any task
+ *	  on the chain may have run, so those are never cached; they are
+ *	  the few tasks blocked on a resource.
+ *
+ * Author(s)
+ *	- Ben Weinstein-Raun, bwr@vt.edu
+ *
+ * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
+ */
+
+#ifndef _CHRONOS_IVD_CACHE_H
+#define _CHRONOS_IVD_CACHE_H
+
+#include <linux/chronos_types.h>
+#include <linux/chronos_sched.h>
+
+static inline bool ivd_cached(struct rt_info * task)
+{
+	return task_check_flag(task, IVD_CACHED) &&
+		task->ivd_util == task->max_util &&
+		compare_ts(&task->ivd_left, &task->left) == 0;
+}
+
+static inline long cached_livd(struct rt_info * task, bool dep_inherit, int flags)
+{
+	bool inherit = dep_inherit && task->dep != NULL;
+
+	if (!inherit && ivd_cached(task) && !task_check_flag(task, DEADLOCKED))
+		return task->local_ivd;
+
+	livd(task, dep_inherit, flags);
+
+	// Deadlocked tasks have just been aborted; don't remember that
+	if (inherit || task_check_flag(task, DEADLOCKED)) {
+		task_clear_flag(task, IVD_CACHED);
+	} else {
+		task->ivd_left = task->left;
+		task->ivd_util = task->max_util;
+		task_set_flag(task, IVD_CACHED);
+	}
+
+	return task->local_ivd;
+}
+
+#endif
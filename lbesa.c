@@ -11,78 +11,254 @@
 #include <linux/module.h>
 #include <linux/chronos_types.h>
 #include <linux/chronos_sched.h>
+#include <linux/errno.h>
 #include <linux/list.h>
+#include <linux/percpu.h>
+#include <linux/slab.h>
 //#include <limits.h>
 
-static inline int schedule_feasible(struct list_head * head, int i) {
-	struct rt_info * it;
-	struct timespec exec_ts = CURRENT_TIME;
-	list_for_each_entry(it, head, task_list[i]) {
-		add_ts(&exec_ts, &(it->left), &exec_ts);
-		if (earlier_deadline(&(it->deadline), &exec_ts)) return 0;
+#include "decision_cache.h"
+#include "ivd_cache.h"
+#include "sched_budget.h"
+#include "rq_snapshot.h"
+#include "sched_trace.h"
+#include "sched_variant.h"
+#include "slack_tree.h"
+
+// Up to this many tasks, shedding works straight on the snapshot; past
+// it, on the slack tree and IVD heap.
+#define LBESA_SNAPSHOT_MAX 64
+
+static DEFINE_PER_CPU(struct rq_snapshot, snapshots);
+static DEFINE_PER_CPU(struct slack_pool, schedule_nodes);
+static DEFINE_PER_CPU(struct decision_cache, decisions);
+
+// Max-heap of the scheduled tasks by IVD, so the next task to shed is
+// always on top.
+struct shed_heap {
+	struct slack_node ** nodes;
+	int size;
+};
+
+static DEFINE_PER_CPU(struct shed_heap, shed_heaps);
+
+static struct slack_node ** shed_heap_get(int size)
+{
+	struct shed_heap * heap = this_cpu_ptr(&shed_heaps);
+	struct slack_node ** nodes;
+
+	if (heap->size < size) {
+		nodes = krealloc(heap->nodes, size * sizeof(*nodes), GFP_ATOMIC);
+		if (nodes == NULL)
+			return NULL;
+		heap->nodes = nodes;
+		heap->size = size;
+	}
+
+	return heap->nodes;
+}
+
+// Highest IVD first, and the latest in deadline order among equals.
+static inline bool more_unworthy(struct slack_node * a, struct slack_node * b)
+{
+	if (a->task->local_ivd != b->task->local_ivd)
+		return a->task->local_ivd > b->task->local_ivd;
+	return slack_before(b, a);
+}
+
+static void shed_sift_down(struct slack_node ** heap, int n, int i)
+{
+	struct slack_node * node = heap[i];
+	int child;
+
+	while ((child = 2 * i + 1) < n) {
+		if (child + 1 < n && more_unworthy(heap[child + 1], heap[child]))
+			child++;
+		if (!more_unworthy(heap[child], node))
+			break;
+		heap[i] = heap[child];
+		i = child;
 	}
-	return 1;
+	heap[i] = node;
 }
 
-struct rt_info* sched_lbesa(struct list_head *head, int flags)
+// The most value-dense task the budget ran out on, and a horizon of now,
+// as nothing shows how long that choice stands
+static struct rt_info * shed_stopped(struct rt_info * task, s64 now,
+				     s64 * horizon)
 {
-	struct list_head schedule;
-	const int SCHEDULE_LIST = SCHED_LIST1;
+	*horizon = now;
+	return task;
+}
+
+// Shed from a deadline-ordered snapshot until what's left is feasible,
+// and return the first task left, lowering *horizon to when what's left
+// runs out of slack. NULL if nothing is left.
+static struct rt_info * shed_snapshot(struct rq_snapshot * snap, s64 now,
+				      struct sched_budget * budget,
+				      s64 * horizon)
+{
+	int remaining, i, best;
+
+	for (remaining = snap->nr; remaining > 0; remaining--) {
+		if (sched_budget_spent(budget)) {
+			best = -1;
+			for (i = 0; i < snap->nr; i++)
+				if (snap->deadline[i] != S64_MAX &&
+				    (best < 0 || snap->ivd[i] < snap->ivd[best]))
+					best = i;
+			return shed_stopped(snap->task[best], now, horizon);
+		}
+
+		sched_trace_check();
+		if (snapshot_first_infeasible(snap, now) == snap->nr) {
+			*horizon = min(*horizon, snapshot_latest_start(snap));
+			for (i = 0; i < snap->nr; i++)
+				if (snap->deadline[i] != S64_MAX)
+					return snap->task[i];
+		}
+		snapshot_drop(snap, snapshot_argmax_ivd(snap));
+		sched_trace_shed(1);
+	}
+
+	return NULL;
+}
+
+static struct rt_info * shed_tree(struct rq_snapshot * snap, s64 now,
+				  struct sched_budget * budget, s64 * horizon)
+{
+	struct slack_tree schedule;
+	struct slack_node * nodes, ** heap, * best;
+	int nr_tasks = snap->nr, i;
+
+	nodes = slack_pool_get(this_cpu_ptr(&schedule_nodes), nr_tasks);
+	heap = shed_heap_get(nr_tasks);
+	if (nodes == NULL || heap == NULL) {
+		*horizon = now;
+		return NULL;
+	}
+
+	// Insert into the schedule in EDF order, breaking deadline ties by
+	// position in the snapshot as shed_snapshot() does
+	slack_tree_init(&schedule);
+	for (i = 0; i < nr_tasks; i++) {
+		__slack_node_init(&nodes[i], snap->task[i], snap->deadline[i],
+				  snap->deadline[i], snap->left[i]);
+		nodes[i].seq = i;
+		slack_reinsert(&schedule, &nodes[i]);
+		heap[i] = &nodes[i];
+	}
 
+	for (i = nr_tasks / 2 - 1; i >= 0; i--)
+		shed_sift_down(heap, nr_tasks, i);
+
+	// The tree keeps every position's slack up to date as tasks are
+	// shed, so each round is one O(1) check plus two O(log n) removals.
+	while (nr_tasks > 0) {
+		// A round is cheap next to reading the clock, so only look
+		// every few of them
+		if (!(nr_tasks & 7) && sched_budget_spent(budget)) {
+			best = heap[0];
+			for (i = 1; i < nr_tasks; i++)
+				if (more_unworthy(best, heap[i]))
+					best = heap[i];
+			return shed_stopped(best->task, now, horizon);
+		}
+
+		sched_trace_check();
+		if (slack_feasible(&schedule, now)) {
+			*horizon = min(*horizon, slack_latest_start(&schedule));
+			return slack_first(&schedule)->task;
+		}
+
+		slack_erase(&schedule, heap[0]);
+		sched_trace_shed(1);
+		heap[0] = heap[--nr_tasks];
+		shed_sift_down(heap, nr_tasks, 0);
+	}
+
+	return NULL;
+}
+
+static __always_inline struct rt_info * __sched_lbesa(struct list_head *head,
+						      int flags, const int variant)
+{
+	struct rq_snapshot * snap = this_cpu_ptr(&snapshots);
+	struct decision_cache * dc = this_cpu_ptr(&decisions);
 	struct rt_info * it;
-	struct list_head * lit;
+	struct sched_budget budget;
+	s64 horizon;
 
-	long ivd;
-	struct rt_info * unworthy;
+	struct timespec now_ts = CURRENT_TIME;
+	s64 now = timespec_to_ns(&now_ts);
 
-	struct timespec * t1;
+	// Nothing has happened that could change the last decision
+	it = decision_cache_get(dc, now, flags);
+	if (it != NULL)
+		return it;
 
-	INIT_LIST_HEAD(&schedule);
+	sched_budget_start(&budget);
+	rq_snapshot_reset(snap);
 
 	list_for_each_entry(it, head, task_list[LOCAL_LIST]) {
 		// if a task is aborted, return it
-		if (check_task_failure(it, flags)) return it;
+		if (sched_task_failed(it, now, variant)) return it;
 
 		// Calculate the inverse value density
-		livd(it, 0, flags);
-
-		initialize_lists(it);
-
-		// Insert into the schedule in EDF order
-		t1 = &it->deadline;
-		lit = &schedule;
-		while (!list_is_last(lit, &schedule)) {
-			if (earlier_deadline(&(list_first_entry(
-					lit,
-					struct rt_info,
-					task_list[SCHEDULE_LIST]
-					)->deadline), t1))
-				break;
-			lit = lit->next;
-		}
-		list_add(&(it->task_list[SCHEDULE_LIST]), lit);
+		cached_livd(it, 0, flags);
+
+		if (rq_snapshot_add(snap, it))
+			return local_task(head->next);
 	}
 
-	while (!list_empty(&schedule)) {
-		if (schedule_feasible(&schedule, SCHEDULE_LIST))
-			return list_first_entry(&schedule,
-						struct rt_info,
-						task_list[SCHEDULE_LIST]);
-		ivd = LONG_MIN;
-		unworthy = NULL;
-		list_for_each_entry(it, &schedule, task_list[SCHEDULE_LIST]) {
-			if (it->local_ivd >= ivd) {
-				ivd = it->local_ivd;
-				unworthy = it;
-			}
-		}
+	if (snap->nr == 0)
+		return NULL;
 
-		list_remove(unworthy, SCHEDULE_LIST);
+	// Shedding drops deadlines from the snapshot, so take this first
+	horizon = snapshot_next_deadline(snap, now);
+
+	// The ready queue is kept in deadline order, so the snapshot already
+	// is the EDF schedule and the common, feasible case is one pass.
+	if (snap->sorted) {
+		sched_trace_check();
+		if (snapshot_first_infeasible(snap, now) == snap->nr) {
+			it = snap->task[0];
+			horizon = min(horizon, snapshot_latest_start(snap));
+		} else if (snap->nr <= LBESA_SNAPSHOT_MAX) {
+			it = shed_snapshot(snap, now, &budget, &horizon);
+		} else {
+			it = shed_tree(snap, now, &budget, &horizon);
+		}
+	} else {
+		it = shed_tree(snap, now, &budget, &horizon);
 	}
 
-	return list_first_entry(head,
-				struct rt_info,
-				task_list[LOCAL_LIST]);
+	// Nothing can be made feasible; run the shortest period task
+	if (it == NULL)
+		it = snap->task[snapshot_argmin_period(snap)];
+
+	decision_cache_set(dc, it, now, horizon, flags);
+	return it;
+}
+
+DEFINE_SCHED_VARIANTS(lbesa_variants, __sched_lbesa);
+
+struct rt_info * sched_lbesa(struct list_head *head, int flags)
+{
+	return sched_trace_decision(SCHED_RT_LBESA, head, flags,
+				    sched_variant(lbesa_variants, flags));
+}
+
+// The ready set or its locks changed under the last decision
+static void lbesa_task_event(struct rt_info * task, int flags)
+{
+	decision_cache_invalidate(&per_cpu(decisions, task->cpu));
+}
+
+static void lbesa_lock_event(struct rt_info * task, struct mutex_head * m,
+			     int flags)
+{
+	decision_cache_invalidate(&per_cpu(decisions, task->cpu));
 }
 
 struct rt_sched_local lbesa = {
@@ -90,19 +266,50 @@ struct rt_sched_local lbesa = {
 	.base.id = SCHED_RT_LBESA,
 	.flags = 0,
 	.schedule = sched_lbesa,
-	.base.sort_key = SORT_KEY_PERIOD,
+	.enqueue = lbesa_task_event,
+	.dequeue = lbesa_task_event,
+	.lock = lbesa_lock_event,
+	.unlock = lbesa_lock_event,
+	.block = lbesa_lock_event,
+	.base.sort_key = SORT_KEY_DEADLINE,
 	.base.list = LIST_HEAD_INIT(lbesa.base.list)
 };
 
 static int __init lbesa_init(void)
 {
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		decision_cache_init(&per_cpu(decisions, cpu));
+		if (rq_snapshot_grow(&per_cpu(snapshots, cpu)) ||
+		    !slack_pool_get(&per_cpu(schedule_nodes, cpu),
+				    RQ_SNAPSHOT_PREALLOC))
+			goto nomem;
+	}
+
 	return add_local_scheduler(&lbesa);
+
+nomem:
+	for_each_possible_cpu(cpu) {
+		rq_snapshot_free(&per_cpu(snapshots, cpu));
+		slack_pool_free(&per_cpu(schedule_nodes, cpu));
+	}
+	return -ENOMEM;
 }
 module_init(lbesa_init);
 
 static void __exit lbesa_exit(void)
 {
+	int cpu;
+
 	remove_local_scheduler(&lbesa);
+
+	for_each_possible_cpu(cpu) {
+		rq_snapshot_free(&per_cpu(snapshots, cpu));
+		slack_pool_free(&per_cpu(schedule_nodes, cpu));
+		kfree(per_cpu(shed_heaps, cpu).nodes);
+		decision_cache_exit(&per_cpu(decisions, cpu));
+	}
 }
 module_exit(lbesa_exit);
 
@@ -0,0 +1,373 @@
+/* chronos/partition.h
+ *
+ * Partitioned scheduling: assigning tasks to CPUs at admission.
+ *
+ * Each CPU runs one of the local schedulers on the tasks it was given
+ * and never sees another CPU's tasks, so nothing migrates. A task is
+ * admitted onto a CPU only if that CPU's task set stays schedulable
+ * under the local policy:
+ *
+ *	- EDF, and the utility accrual schedulers (which behave like EDF
+ *	  whenever EDF can meet every deadline): total utilization <= 1.
+ *	- RMA and ICPP: the Liu & Layland bound n(2^(1/n) - 1) as a quick
+ *	  sufficient test, then exact response time analysis for sets
+ *	  above it. Blocking on resources is not accounted for.
+ *
+ * Deadlines are taken to be implicit (equal to the period). Everything
+ * is integer: utilizations are in parts per billion, rounded up, so a
+ * set whose sum is at or under a bound really is. Only a set within a
+ * part per billion per task of U = 1 can be at 1 and still over in ppb;
+ * the EDF test settles that case by adding the utilizations up exactly,
+ * as fractions, so sets at exactly U = 1 fit and sets over it never do.
+ *
+ * Tasks can be placed first fit (lowest numbered CPU they fit on, which
+ * packs tasks onto few CPUs) or worst fit (the least utilized CPU, which
+ * spreads them out). partition_tasks() places a whole set in decreasing
+ * utilization order, which is what makes both heuristics work well.
+ *
+ * Author(s)
+ *	- Ben Weinstein-Raun, bwr@vt.edu
+ *
+ * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
+ */
+
+#ifndef _CHRONOS_PARTITION_H
+#define _CHRONOS_PARTITION_H
+
+#include <linux/errno.h>
+#include <linux/gcd.h>
+#include <linux/math64.h>
+#include <linux/percpu.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/string.h>
+#include <linux/time.h>
+#include <linux/types.h>
+#include <linux/chronos_types.h>
+
+#define PARTITION_UTIL_ONE	1000000000ULL
+
+enum partition_test {
+	PARTITION_EDF,
+	PARTITION_RM,
+};
+
+enum partition_fit {
+	PARTITION_FIRST_FIT,
+	PARTITION_WORST_FIT,
+};
+
+struct partition_load {
+	u64 period;
+	u64 exec;
+};
+
+// What has been admitted to one CPU, by period (RM priority order)
+struct partition_cpu {
+	struct partition_load * tasks;
+	int nr;
+	int size;
+	u64 util;
+};
+
+struct partition {
+	enum partition_test test;
+	enum partition_fit fit;
+	int nr_cpus;
+	struct partition_cpu cpu[NR_CPUS];
+};
+
+// n(2^(1/n) - 1) in ppb, rounded down; it only falls from here towards
+// ln 2, so ln 2 is a safe bound for anything larger
+static const u64 liu_layland_ppb[] = {
+	0, 1000000000, 828427124, 779763149, 756828460, 743491774,
+	734772289, 728626595, 724061861, 720537650, 717734625,
+};
+#define LIU_LAYLAND_LN2_PPB	693147180
+
+// The test for the scheduler a CPU runs
+static inline enum partition_test partition_test_for(int sched_id)
+{
+	switch (sched_id) {
+	case SCHED_RT_RMA:
+	case SCHED_RT_ICPP:
+		return PARTITION_RM;
+	default:
+		return PARTITION_EDF;
+	}
+}
+
+static inline void partition_init(struct partition * p, int nr_cpus,
+				  enum partition_test test, enum partition_fit fit)
+{
+	memset(p, 0, sizeof(*p));
+	p->nr_cpus = min(nr_cpus, NR_CPUS);
+	p->test = test;
+	p->fit = fit;
+}
+
+static inline void partition_free(struct partition * p)
+{
+	int cpu;
+
+	for (cpu = 0; cpu < NR_CPUS; cpu++)
+		kfree(p->cpu[cpu].tasks);
+	memset(p->cpu, 0, sizeof(p->cpu));
+}
+
+/*
+ * Utilization in ppb, rounded to nearest with round_up false and up
+ * otherwise. Only the rounded up value is safe to admit against; the
+ * nearest one is for ordering tasks.
+ */
+static inline u64 __partition_util(u64 period, u64 exec, bool round_up)
+{
+	// Keep exec * PARTITION_UTIL_ONE in range for exec over ~18s,
+	// rounding the ratio up while doing so if that is wanted
+	while (exec > U64_MAX / PARTITION_UTIL_ONE) {
+		exec = (exec + round_up) >> 1;
+		period >>= 1;
+	}
+	if (period == 0)
+		return 2 * PARTITION_UTIL_ONE;
+	return div64_u64(exec * PARTITION_UTIL_ONE +
+			 (round_up ? period - 1 : period / 2), period);
+}
+
+static inline u64 partition_util(u64 period, u64 exec)
+{
+	return __partition_util(period, exec, true);
+}
+
+static inline u64 liu_layland_bound(int n)
+{
+	if (n < (int) ARRAY_SIZE(liu_layland_ppb))
+		return liu_layland_ppb[n];
+	return LIU_LAYLAND_LN2_PPB;
+}
+
+/*
+ * Worst case response time of the task at index i of a set in priority
+ * order, or 0 if it exceeds its period.
+ */
+static inline u64 partition_response_time(struct partition_load * tasks, int i)
+{
+	u64 r = tasks[i].exec, prev = 0;
+	int j;
+
+	while (r != prev) {
+		if (r > tasks[i].period)
+			return 0;
+		prev = r;
+		r = tasks[i].exec;
+		for (j = 0; j < i; j++)
+			r += div64_u64(prev + tasks[j].period - 1, tasks[j].period) *
+				tasks[j].exec;
+	}
+	return r;
+}
+
+// Where a task with this period goes in RM priority order, after any
+// with the same period
+static inline int partition_rm_index(struct partition_cpu * c, u64 period)
+{
+	int i = c->nr;
+
+	while (i > 0 && c->tasks[i - 1].period > period)
+		i--;
+	return i;
+}
+
+// Add exec / period to num / *den exactly; false if the sum is over 1
+// or the denominator would overflow
+static inline bool partition_util_add(u64 * num, u64 * den, u64 period, u64 exec)
+{
+	u64 g = gcd(period, exec), lcm, a, b;
+
+	if (exec > period)
+		return false;
+	if (g) {
+		period /= g;
+		exec /= g;
+	}
+
+	g = gcd(*den, period);
+	if (*den / g > U64_MAX / period)
+		return false;
+	lcm = *den / g * period;
+
+	// Each term is at most lcm, as the sum so far is at most 1, but
+	// together they can pass it, and U64_MAX with it
+	a = *num * (lcm / *den);
+	b = exec * (lcm / period);
+	if (a > lcm - b)
+		return false;
+	*num = a + b;
+	*den = lcm;
+	return true;
+}
+
+/*
+ * Whether the CPU's set with t added has utilization at most 1, exactly.
+ * A set whose denominators don't fit in 64 bits counts as over, which
+ * only ever errs towards turning t away.
+ */
+static inline bool partition_util_exact(struct partition_cpu * c,
+					struct partition_load t)
+{
+	u64 num = 0, den = 1;
+	int i;
+
+	for (i = 0; i < c->nr; i++)
+		if (!partition_util_add(&num, &den, c->tasks[i].period,
+					c->tasks[i].exec))
+			return false;
+	return partition_util_add(&num, &den, t.period, t.exec);
+}
+
+// Would the CPU's set still be schedulable with t added?
+static inline bool partition_fits(struct partition * p, int cpu,
+				  struct partition_load t)
+{
+	struct partition_cpu * c = &p->cpu[cpu];
+	u64 util = c->util + partition_util(t.period, t.exec);
+	struct partition_load * tasks;
+	bool fits = true;
+	int i, at;
+
+	if (util > PARTITION_UTIL_ONE && !partition_util_exact(c, t))
+		return false;
+	if (p->test == PARTITION_EDF || util <= liu_layland_bound(c->nr + 1))
+		return true;
+
+	// Response time analysis on the set with t in its place. Only t and
+	// the tasks below it can be affected.
+	tasks = kmalloc((c->nr + 1) * sizeof(*tasks), GFP_KERNEL);
+	if (tasks == NULL)
+		return false;
+
+	at = partition_rm_index(c, t.period);
+	memcpy(tasks, c->tasks, at * sizeof(*tasks));
+	tasks[at] = t;
+	memcpy(tasks + at + 1, c->tasks + at, (c->nr - at) * sizeof(*tasks));
+
+	for (i = at; i <= c->nr && fits; i++)
+		fits = partition_response_time(tasks, i) != 0;
+
+	kfree(tasks);
+	return fits;
+}
+
+static inline int partition_add(struct partition * p, int cpu,
+				struct partition_load t)
+{
+	struct partition_cpu * c = &p->cpu[cpu];
+	struct partition_load * tasks;
+	int size, at;
+
+	if (c->nr == c->size) {
+		size = c->size ? 2 * c->size : 16;
+		tasks = krealloc(c->tasks, size * sizeof(*tasks), GFP_KERNEL);
+		if (tasks == NULL)
+			return -ENOMEM;
+		c->tasks = tasks;
+		c->size = size;
+	}
+
+	at = partition_rm_index(c, t.period);
+	memmove(c->tasks + at + 1, c->tasks + at, (c->nr - at) * sizeof(*tasks));
+	c->tasks[at] = t;
+	c->nr++;
+	c->util += partition_util(t.period, t.exec);
+	return 0;
+}
+
+static inline struct partition_load partition_load_of(struct rt_info * task)
+{
+	struct partition_load t = {
+		.period = timespec_to_ns(&task->period),
+		.exec = timespec_to_ns(&task->exec_time),
+	};
+
+	return t;
+}
+
+/*
+ * Admit a task: pick a CPU for it and set task->cpu. Returns the CPU,
+ * or -ENOSPC if it doesn't fit anywhere.
+ */
+static inline int partition_admit(struct partition * p, struct rt_info * task)
+{
+	struct partition_load t = partition_load_of(task);
+	int cpu, best = -1;
+
+	if (t.period == 0)
+		return -EINVAL;
+
+	for (cpu = 0; cpu < p->nr_cpus; cpu++) {
+		if (best >= 0 && (p->fit == PARTITION_FIRST_FIT ||
+				  p->cpu[cpu].util >= p->cpu[best].util))
+			continue;
+		if (partition_fits(p, cpu, t))
+			best = cpu;
+	}
+
+	if (best < 0)
+		return -ENOSPC;
+	if (partition_add(p, best, t))
+		return -ENOMEM;
+
+	task->cpu = best;
+	return best;
+}
+
+// Take a task that is leaving the system off its CPU
+static inline void partition_release(struct partition * p, struct rt_info * task)
+{
+	struct partition_load t = partition_load_of(task);
+	struct partition_cpu * c = &p->cpu[task->cpu];
+	int i;
+
+	for (i = 0; i < c->nr; i++) {
+		if (c->tasks[i].period == t.period && c->tasks[i].exec == t.exec) {
+			memmove(c->tasks + i, c->tasks + i + 1,
+				(c->nr - i - 1) * sizeof(*c->tasks));
+			c->nr--;
+			c->util -= partition_util(t.period, t.exec);
+			return;
+		}
+	}
+}
+
+static int partition_util_cmp(const void * a, const void * b)
+{
+	struct rt_info * x = *(struct rt_info **) a, * y = *(struct rt_info **) b;
+	struct partition_load lx = partition_load_of(x), ly = partition_load_of(y);
+	u64 ux = __partition_util(lx.period, lx.exec, false);
+	u64 uy = __partition_util(ly.period, ly.exec, false);
+
+	return ux > uy ? -1 : ux < uy;
+}
+
+/*
+ * Place a whole task set, largest utilization first. Tasks that fit
+ * nowhere get cpu -1. Reorders tasks[]; returns how many didn't fit.
+ */
+static inline int partition_tasks(struct partition * p, struct rt_info ** tasks,
+				  int nr)
+{
+	int i, rejected = 0;
+
+	sort(tasks, nr, sizeof(*tasks), partition_util_cmp, NULL);
+
+	for (i = 0; i < nr; i++) {
+		if (partition_admit(p, tasks[i]) < 0) {
+			tasks[i]->cpu = -1;
+			rejected++;
+		}
+	}
+
+	return rejected;
+}
+
+#endif
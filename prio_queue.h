@@ -0,0 +1,245 @@
+/* chronos/prio_queue.h
+ *
+ * Fixed-priority ready queue with O(1) selection, for the fixed-priority
+ * schedulers.
+ *
+ * Each priority in use on a CPU gets a level: a FIFO list of the ready
+ * tasks at that priority, and a bit in a bitmap that is set while the
+ * list is non-empty. The highest priority ready task is then the head of
+ * the list of the first set bit, found with find_first_bit() over a few
+ * words no matter how many tasks are ready.
+ *
+ * Priorities are the schedulers' dynamic_priority values, where smaller
+ * is more important (a period in us, or a ceiling made of one). They are
+ * not small integers, so the levels are kept as a sorted table of the
+ * priorities in use, and a task's level is found by binary search. A new
+ * priority shifts the levels above it up by one; that only happens when
+ * the task set changes, and costs O(PRIO_LEVELS). Levels that have
+ * emptied are only reclaimed when the table is full.
+ *
+ * If more than PRIO_LEVELS distinct priorities are queued at once, a
+ * level holds every priority from its own up to the next level's, kept
+ * in order within its list. Selection stays O(1); only queueing into
+ * such a level walks it.
+ *
+ * Author(s)
+ *	- Ben Weinstein-Raun, bwr@vt.edu
+ *
+ * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
+ */
+
+#ifndef _CHRONOS_PRIO_QUEUE_H
+#define _CHRONOS_PRIO_QUEUE_H
+
+#include <linux/bitops.h>
+#include <linux/list.h>
+#include <linux/string.h>
+#include <linux/types.h>
+#include <linux/chronos_types.h>
+
+#define PRIO_LEVELS	256
+#define PQ_LIST		SCHED_LIST3
+
+struct prio_queue {
+	DECLARE_BITMAP(bitmap, PRIO_LEVELS);
+	struct list_head level[PRIO_LEVELS];
+	// The lowest priority of each level, in increasing order
+	unsigned long prio[PRIO_LEVELS];
+	int nr_levels;
+};
+
+static inline void pq_init(struct prio_queue * q)
+{
+	int i;
+
+	memset(q->bitmap, 0, sizeof(q->bitmap));
+	for (i = 0; i < PRIO_LEVELS; i++)
+		INIT_LIST_HEAD(&q->level[i]);
+	q->nr_levels = 0;
+}
+
+static inline struct rt_info * pq_task(struct list_head * pos)
+{
+	return list_entry(pos, struct rt_info, task_list[PQ_LIST]);
+}
+
+// Position of the first level with a priority of at least prio
+static inline int pq_lower_bound(struct prio_queue * q, unsigned long prio)
+{
+	int lo = 0, hi = q->nr_levels, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (q->prio[mid] < prio)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+// The level holding prio
+static inline int pq_level_of(struct prio_queue * q, unsigned long prio)
+{
+	int i = pq_lower_bound(q, prio);
+
+	if (i < q->nr_levels && q->prio[i] == prio)
+		return i;
+	return i - 1;
+}
+
+static inline void pq_update_bit(struct prio_queue * q, int i)
+{
+	if (list_empty(&q->level[i]))
+		__clear_bit(i, q->bitmap);
+	else
+		__set_bit(i, q->bitmap);
+}
+
+// Move level from to level to, which must be empty
+static inline void pq_move_level(struct prio_queue * q, int from, int to)
+{
+	list_splice_init(&q->level[from], &q->level[to]);
+	q->prio[to] = q->prio[from];
+	pq_update_bit(q, from);
+	pq_update_bit(q, to);
+}
+
+// Drop the levels with no tasks. The level below each one dropped takes
+// over its range, which holds nothing.
+static inline void pq_compact(struct prio_queue * q)
+{
+	int i, nr = 0;
+
+	for (i = 0; i < q->nr_levels; i++) {
+		if (list_empty(&q->level[i]))
+			continue;
+		if (i != nr)
+			pq_move_level(q, i, nr);
+		nr++;
+	}
+	q->nr_levels = nr;
+}
+
+// Add a level for prio at position at, taking over the tasks of the
+// level below that are now in its range
+static inline void pq_add_level(struct prio_queue * q, int at,
+				unsigned long prio)
+{
+	struct list_head * below;
+	int i;
+
+	for (i = q->nr_levels; i > at; i--)
+		pq_move_level(q, i - 1, i);
+	q->prio[at] = prio;
+	q->nr_levels++;
+
+	if (at == 0)
+		return;
+	below = &q->level[at - 1];
+	while (!list_empty(below) && pq_task(below->prev)->dynamic_priority >= prio)
+		list_move(below->prev, &q->level[at]);
+	pq_update_bit(q, at - 1);
+	pq_update_bit(q, at);
+}
+
+// The level to queue prio at, adding one for it if there is room
+static inline int pq_level(struct prio_queue * q, unsigned long prio)
+{
+	int at = pq_lower_bound(q, prio);
+
+	if (at < q->nr_levels && q->prio[at] == prio)
+		return at;
+
+	if (q->nr_levels == PRIO_LEVELS) {
+		pq_compact(q);
+		at = pq_lower_bound(q, prio);
+	}
+
+	if (q->nr_levels < PRIO_LEVELS) {
+		pq_add_level(q, at, prio);
+		return at;
+	}
+
+	// Full: share the level below, or widen the lowest one downwards
+	if (at == 0) {
+		q->prio[0] = prio;
+		return 0;
+	}
+	return at - 1;
+}
+
+static inline bool pq_queued(struct rt_info * task)
+{
+	return !list_empty(&task->task_list[PQ_LIST]);
+}
+
+/*
+ * Queue task at its dynamic_priority, behind the tasks already there, or
+ * ahead of them if head is set.
+ */
+static inline void pq_enqueue(struct prio_queue * q, struct rt_info * task,
+			      bool head)
+{
+	unsigned long prio = task->dynamic_priority;
+	int i = pq_level(q, prio);
+	struct list_head * level = &q->level[i], * pos;
+
+	// Only a level holding several priorities needs walking; the ends
+	// are checked first so that the extremes don't
+	if (list_empty(level) || (head ?
+	    pq_task(level->next)->dynamic_priority >= prio :
+	    pq_task(level->next)->dynamic_priority > prio)) {
+		list_add(&task->task_list[PQ_LIST], level);
+	} else if (head) {
+		list_for_each(pos, level)
+			if (pq_task(pos)->dynamic_priority >= prio)
+				break;
+		list_add_tail(&task->task_list[PQ_LIST], pos);
+	} else {
+		for (pos = level->prev; pos != level; pos = pos->prev)
+			if (pq_task(pos)->dynamic_priority <= prio)
+				break;
+		list_add(&task->task_list[PQ_LIST], pos);
+	}
+	__set_bit(i, q->bitmap);
+}
+
+// Take task off the queue; its dynamic_priority must not have changed
+static inline void pq_dequeue(struct prio_queue * q, struct rt_info * task)
+{
+	int i;
+
+	if (!pq_queued(task))
+		return;
+
+	i = pq_level_of(q, task->dynamic_priority);
+	list_del_init(&task->task_list[PQ_LIST]);
+	if (i >= 0)
+		pq_update_bit(q, i);
+}
+
+// Give a task a new dynamic_priority, moving it if it is queued
+static inline void pq_requeue(struct prio_queue * q, struct rt_info * task,
+			      unsigned long prio, bool head)
+{
+	bool queued = pq_queued(task);
+
+	if (queued)
+		pq_dequeue(q, task);
+	task->dynamic_priority = prio;
+	if (queued)
+		pq_enqueue(q, task, head);
+}
+
+// The highest priority task, first come first served among equals
+static inline struct rt_info * pq_first(struct prio_queue * q)
+{
+	int i = find_first_bit(q->bitmap, PRIO_LEVELS);
+
+	if (i >= PRIO_LEVELS)
+		return NULL;
+	return pq_task(q->level[i].next);
+}
+
+#endif
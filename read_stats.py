@@ -0,0 +1,19 @@
+# Turn a snapshot of the per-CPU statistics (from
+# /sys/kernel/debug/chronos_stats) on stdin into CSV on stdout, one line
+# per possible CPU.
+import struct
+import sys
+
+RECORD = struct.Struct("<8Q")
+
+stream = getattr(sys.stdin, "buffer", sys.stdin)
+
+print("cpu,released,met,missed,aborted,utility,preemptions,decisions,budget_hits")
+cpu = 0
+while True:
+	record = stream.read(RECORD.size)
+	if len(record) < RECORD.size:
+		break
+
+	print("{0},{1},{2},{3},{4},{5},{6},{7},{8}".format(cpu, *RECORD.unpack(record)))
+	cpu += 1
@@ -0,0 +1,25 @@
+# Turn sched_trace records (from /sys/kernel/debug/chronos/cpuN, or from
+# userspace/bench -T) on stdin into CSV on stdout.
+import struct
+import sys
+
+RECORD = struct.Struct("<QQIIIIHHI")
+
+SCHEDULERS = {
+	0x00: "FIFO", 0x01: "RMA", 0x02: "EDF", 0x03: "HVDF", 0x04: "LBESA",
+	0x05: "DASA_ND", 0x06: "DASA", 0x07: "ICPP", 0x08: "HYBRID",
+	0x82: "G_EDF",
+	0x85: "G_DASA",
+}
+
+stream = getattr(sys.stdin, "buffer", sys.stdin)
+
+print("cpu,scheduler,time_ns,deadline_ns,latency_ns,ready,shed,checks")
+while True:
+	record = stream.read(RECORD.size)
+	if len(record) < RECORD.size:
+		break
+
+	time, deadline, latency, ready, shed, checks, sched, cpu, _ = RECORD.unpack(record)
+	print("{0},{1},{2},{3},{4},{5},{6},{7}".format(cpu,
+		SCHEDULERS.get(sched, sched), time, deadline, latency, ready, shed, checks))
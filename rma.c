@@ -4,6 +4,7 @@
  *
  * Author(s)
  *	- Matthew Dellinger, mdelling@vt.edu
+ *	- Ben Weinstein-Raun, bwr@vt.edu
  *
  * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
  */
@@ -11,40 +12,224 @@
 #include <linux/module.h>
 #include <linux/chronos_types.h>
 #include <linux/chronos_sched.h>
+#include <linux/errno.h>
 #include <linux/list.h>
+#include <linux/percpu.h>
+#include <linux/slab.h>
 
-struct rt_info* sched_rma(struct list_head *head, int flags)
+#include "prio_queue.h"
+#include "sched_trace.h"
+
+/*
+ * Rate monotonic: the ready task with the shortest period runs, first
+ * come first served among equal periods. Ready tasks are kept in a
+ * per-CPU priority bitmap queue (prio_queue.h), so release, completion
+ * and the decision itself all take O(1) however many tasks are ready,
+ * and the core no longer has to keep the ready list sorted.
+ *
+ * With SCHED_FLAG_PI, a task holding a lock runs at the priority of the
+ * highest priority task blocked on it, if that is higher than its own.
+ * Each task keeps the tasks blocked on it in priority order, so a boost
+ * or unboost on a lock event only touches the tasks along the chain of
+ * owners involved, and never walks the ready queue. Inheritance stops at
+ * the edge of the CPU: an owner on another CPU is not boosted.
+ */
+
+// Tasks blocked on locks this task holds, highest priority first
+static const int PI_WAITERS = SCHED_LIST1;
+// This task's place on its owner's PI_WAITERS; its owner is in task->dep
+static const int PI_WAITER = SCHED_LIST2;
+
+// Longer chains of owners are deadlocks, which RMA doesn't resolve
+#define RMA_MAX_CHAIN	16
+
+// Too big for static per-CPU space; allocated at init
+static DEFINE_PER_CPU(struct prio_queue *, rma_queues);
+
+static inline unsigned long rma_base_priority(struct rt_info * task)
 {
-	struct rt_info *best = local_task(head->next);
+	return timespec_to_long(&task->period);
+}
 
-	if(flags & SCHED_FLAG_PI)
-		best = get_pi_task(best, head, flags);
+static inline struct rt_info * rma_waiter(struct list_head * pos)
+{
+	return list_entry(pos, struct rt_info, task_list[PI_WAITER]);
+}
+
+// Its own priority, or that of the highest priority task blocked on it
+static unsigned long rma_effective_priority(struct rt_info * task)
+{
+	unsigned long prio = rma_base_priority(task);
+	struct list_head * waiters = &task->task_list[PI_WAITERS];
+
+	if (!list_empty(waiters))
+		prio = min(prio, rma_waiter(waiters->next)->dynamic_priority);
+	return prio;
+}
+
+// Put waiter on owner's PI_WAITERS, behind the waiters of equal priority
+static void rma_add_waiter(struct rt_info * owner, struct rt_info * waiter)
+{
+	struct list_head * head = &owner->task_list[PI_WAITERS], * pos;
+
+	list_for_each(pos, head)
+		if (rma_waiter(pos)->dynamic_priority > waiter->dynamic_priority)
+			break;
+	list_add_tail(&waiter->task_list[PI_WAITER], pos);
+	waiter->dep = owner;
+}
+
+static void rma_remove_waiter(struct rt_info * waiter)
+{
+	list_del_init(&waiter->task_list[PI_WAITER]);
+	waiter->dep = NULL;
+}
+
+/*
+ * The tasks blocked on task have changed: bring its priority up to date,
+ * then its place among its own owner's waiters and that owner's priority,
+ * and so on up the chain until a priority doesn't change. A task whose
+ * priority changes goes ahead of the others at its new priority, since
+ * it was either running or is about to.
+ */
+static void rma_update_chain(struct rt_info * task)
+{
+	struct rt_info * owner;
+	unsigned long prio;
+	int i;
+
+	for (i = 0; i < RMA_MAX_CHAIN; i++) {
+		prio = rma_effective_priority(task);
+		if (prio == task->dynamic_priority)
+			break;
+		pq_requeue(per_cpu(rma_queues, task->cpu), task, prio, true);
+
+		if (list_empty(&task->task_list[PI_WAITER]))
+			break;
+		owner = task->dep;
+		list_del_init(&task->task_list[PI_WAITER]);
+		rma_add_waiter(owner, task);
+		task = owner;
+	}
+}
+
+void enqueue_rma(struct rt_info * task, int flags)
+{
+	task->dynamic_priority = rma_effective_priority(task);
+	pq_enqueue(per_cpu(rma_queues, task->cpu), task, false);
+}
+
+// A task blocked on a lock stays on its owner's waiters while it is off
+// the ready queue, and keeps the owner boosted
+void dequeue_rma(struct rt_info * task, int flags)
+{
+	pq_dequeue(per_cpu(rma_queues, task->cpu), task);
+}
+
+void block_rma(struct rt_info * task, struct mutex_head * m, int flags)
+{
+	struct rt_info * owner = m->owner_t;
+
+	if (!(flags & SCHED_FLAG_PI) || owner == NULL || owner == task ||
+	    owner->cpu != task->cpu)
+		return;
+
+	if (!list_empty(&task->task_list[PI_WAITER]))
+		rma_remove_waiter(task);
+	rma_add_waiter(owner, task);
+	rma_update_chain(owner);
+}
+
+// The tasks blocked on m stop boosting task; the next owner of m picks
+// up those that block on it again
+void unlock_rma(struct rt_info * task, struct mutex_head * m, int flags)
+{
+	struct list_head * pos, * n;
+
+	if (!(flags & SCHED_FLAG_PI))
+		return;
+
+	list_for_each_safe(pos, n, &task->task_list[PI_WAITERS])
+		if (rma_waiter(pos)->requested_resource == m)
+			rma_remove_waiter(rma_waiter(pos));
+
+	rma_update_chain(task);
+}
+
+static struct rt_info * __sched_rma(struct list_head *head, int flags)
+{
+	struct prio_queue * q = __this_cpu_read(rma_queues);
+	struct rt_info * best = pq_first(q), * owner;
+	int i;
+
+	if (best == NULL || !(flags & SCHED_FLAG_PI))
+		return best;
+
+	// The owner at the end of the chain has been boosted to best's
+	// priority and queued ahead of it, unless best blocked without the
+	// core telling us; then find the owner the slow way
+	for (i = 0; i < RMA_MAX_CHAIN && best->requested_resource != NULL; i++) {
+		owner = best->requested_resource->owner_t;
+		if (owner == NULL || owner == best || owner->cpu != best->cpu ||
+		    !pq_queued(owner))
+			break;
+		best = owner;
+	}
 
 	return best;
 }
 
+struct rt_info * sched_rma(struct list_head *head, int flags)
+{
+	return sched_trace_decision(SCHED_RT_RMA, head, flags, __sched_rma);
+}
+
 struct rt_sched_local rma = {
 	.base.name = "RMA",
 	.base.id = SCHED_RT_RMA,
 	.flags = 0,
 	.schedule = sched_rma,
-	.base.sort_key = SORT_KEY_PERIOD,
+	.enqueue = enqueue_rma,
+	.dequeue = dequeue_rma,
+	.unlock = unlock_rma,
+	.block = block_rma,
+	.base.sort_key = SORT_KEY_NONE,
 	.base.list = LIST_HEAD_INIT(rma.base.list)
 };
 
 static int __init rma_init(void)
 {
+	struct prio_queue * q;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		q = kmalloc(sizeof(*q), GFP_KERNEL);
+		if (q == NULL)
+			goto fail;
+		pq_init(q);
+		per_cpu(rma_queues, cpu) = q;
+	}
+
 	return add_local_scheduler(&rma);
+
+fail:
+	for_each_possible_cpu(cpu)
+		kfree(per_cpu(rma_queues, cpu));
+	return -ENOMEM;
 }
 module_init(rma_init);
 
 static void __exit rma_exit(void)
 {
+	int cpu;
+
 	remove_local_scheduler(&rma);
+
+	for_each_possible_cpu(cpu)
+		kfree(per_cpu(rma_queues, cpu));
 }
 module_exit(rma_exit);
 
 MODULE_DESCRIPTION("RMA Single-Core Scheduling Module for ChronOS");
 MODULE_AUTHOR("Matthew Dellinger <matthew@mdelling.com>");
 MODULE_LICENSE("GPL");
-
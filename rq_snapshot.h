@@ -0,0 +1,254 @@
+/* chronos/rq_snapshot.h
+ *
+ * Structure-of-arrays snapshot of a CPU's ready queue.
+ *
+ * The schedulers take one pass over the ready list per decision, copying
+ * the fields they need into contiguous arrays with deadlines and
+ * remaining times as 64-bit ns. Everything after that works on the
+ * arrays instead of chasing rt_info pointers and adding up timespecs.
+ *
+ * The kernels below are written as plain loops over those arrays so the
+ * compiler can vectorize them where it is allowed to. In the kernel,
+ * where the scheduler can't touch FPU/SIMD registers without
+ * kernel_fpu_begin(), they still get the benefit of dense, sequential
+ * memory access.
+ *
+ * The arrays belong to one CPU and only grow. Modules allocate them for
+ * RQ_SNAPSHOT_PREALLOC tasks when they load, so a CPU whose ready queue
+ * stays that small never allocates while scheduling.
+ *
+ * Remaining times include the overhead charge of sched_overhead.h, as of
+ * rq_snapshot_reset(), so the kernels below test feasibility with it.
+ *
+ * Author(s)
+ *	- Ben Weinstein-Raun, bwr@vt.edu
+ *
+ * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
+ */
+
+#ifndef _CHRONOS_RQ_SNAPSHOT_H
+#define _CHRONOS_RQ_SNAPSHOT_H
+
+#include <linux/errno.h>
+#include <linux/types.h>
+#include <linux/time.h>
+#include <linux/string.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/chronos_types.h>
+
+#include "sched_overhead.h"
+
+#define RQ_SNAPSHOT_PREALLOC	64
+
+struct rq_snapshot_key {
+	long ivd;
+	int index;
+};
+
+struct rq_snapshot {
+	int nr;
+	int size;
+
+	s64 * deadline;
+	s64 * left;
+	s64 * period;
+	long * ivd;
+	struct rt_info ** task;
+
+	// Scratch for rq_snapshot_sort_ivd()
+	struct rq_snapshot_key * keys;
+	int * order;
+
+	// Whether the tasks were added in deadline order
+	bool sorted;
+	// Added to each task's remaining time (ns)
+	s64 charge;
+};
+
+static inline void rq_snapshot_free(struct rq_snapshot * snap)
+{
+	kfree(snap->deadline);
+	kfree(snap->left);
+	kfree(snap->period);
+	kfree(snap->ivd);
+	kfree(snap->task);
+	kfree(snap->keys);
+	kfree(snap->order);
+	memset(snap, 0, sizeof(*snap));
+}
+
+#define __snapshot_grow(snap, field, size) ({					\
+	void * __p = krealloc((snap)->field, (size) * sizeof(*(snap)->field),	\
+			      GFP_ATOMIC);					\
+	if (__p != NULL)							\
+		(snap)->field = __p;						\
+	__p != NULL;								\
+})
+
+static inline int rq_snapshot_grow(struct rq_snapshot * snap)
+{
+	int size = snap->size ? 2 * snap->size : RQ_SNAPSHOT_PREALLOC;
+
+	if (!__snapshot_grow(snap, deadline, size) ||
+	    !__snapshot_grow(snap, left, size) ||
+	    !__snapshot_grow(snap, period, size) ||
+	    !__snapshot_grow(snap, ivd, size) ||
+	    !__snapshot_grow(snap, task, size) ||
+	    !__snapshot_grow(snap, keys, size) ||
+	    !__snapshot_grow(snap, order, size))
+		return -ENOMEM;
+
+	snap->size = size;
+	return 0;
+}
+
+static inline void rq_snapshot_reset(struct rq_snapshot * snap)
+{
+	snap->nr = 0;
+	snap->sorted = true;
+	snap->charge = sched_overhead_charge();
+}
+
+// Append a task; its local_ivd should already be up to date
+static inline int rq_snapshot_add(struct rq_snapshot * snap, struct rt_info * task)
+{
+	int i = snap->nr;
+
+	if (i == snap->size && rq_snapshot_grow(snap))
+		return -ENOMEM;
+
+	snap->deadline[i] = timespec_to_ns(&task->deadline);
+	snap->left[i] = timespec_to_ns(&task->left) + snap->charge;
+	snap->period[i] = timespec_to_ns(&task->period);
+	snap->ivd[i] = task->local_ivd;
+	snap->task[i] = task;
+
+	if (i > 0 && snap->deadline[i] < snap->deadline[i - 1])
+		snap->sorted = false;
+
+	snap->nr++;
+	return 0;
+}
+
+// Index of the smallest of nr values, the first one among equals
+static inline int snapshot_argmin(s64 * v, int nr)
+{
+	s64 best = S64_MAX;
+	int i;
+
+	for (i = 0; i < nr; i++)
+		best = min(best, v[i]);
+	for (i = 0; i < nr; i++)
+		if (v[i] == best)
+			break;
+	return i;
+}
+
+static inline int snapshot_argmin_deadline(struct rq_snapshot * snap)
+{
+	return snapshot_argmin(snap->deadline, snap->nr);
+}
+
+static inline int snapshot_argmin_period(struct rq_snapshot * snap)
+{
+	return snapshot_argmin(snap->period, snap->nr);
+}
+
+// Index of the highest IVD, the last one among equals
+static inline int snapshot_argmax_ivd(struct rq_snapshot * snap)
+{
+	long best = LONG_MIN;
+	int i;
+
+	for (i = 0; i < snap->nr; i++)
+		best = max(best, snap->ivd[i]);
+	for (i = snap->nr - 1; i > 0; i--)
+		if (snap->ivd[i] == best)
+			break;
+	return i;
+}
+
+/*
+ * Run the tasks back to back from now, in snapshot order, and return the
+ * index of the first one to miss its deadline, or nr if none do. Only
+ * meaningful for a snapshot taken in deadline order.
+ */
+static inline int snapshot_first_infeasible(struct rq_snapshot * snap, s64 now)
+{
+	s64 finish = now;
+	int i;
+
+	for (i = 0; i < snap->nr; i++) {
+		finish += snap->left[i];
+		if (snap->deadline[i] < finish)
+			break;
+	}
+	return i;
+}
+
+/*
+ * The latest time the tasks could start, run back to back in snapshot
+ * order, and all still meet their deadlines. Dropped tasks don't count.
+ */
+static inline s64 snapshot_latest_start(struct rq_snapshot * snap)
+{
+	s64 finish = 0, latest = S64_MAX;
+	int i;
+
+	for (i = 0; i < snap->nr; i++) {
+		finish += snap->left[i];
+		latest = min(latest, snap->deadline[i] - finish);
+	}
+	return latest;
+}
+
+// The earliest deadline after now, or S64_MAX
+static inline s64 snapshot_next_deadline(struct rq_snapshot * snap, s64 now)
+{
+	s64 next = S64_MAX;
+	int i;
+
+	for (i = 0; i < snap->nr; i++)
+		if (snap->deadline[i] > now)
+			next = min(next, snap->deadline[i]);
+	return next;
+}
+
+// Take a task out of consideration by the kernels above without moving
+// anything: it no longer takes time, can't miss, and is never the most
+// unworthy again.
+static inline void snapshot_drop(struct rq_snapshot * snap, int i)
+{
+	snap->left[i] = 0;
+	snap->deadline[i] = S64_MAX;
+	snap->ivd[i] = LONG_MIN;
+}
+
+static int snapshot_key_cmp(const void * a, const void * b)
+{
+	const struct rq_snapshot_key * x = a, * y = b;
+
+	if (x->ivd != y->ivd)
+		return x->ivd < y->ivd ? -1 : 1;
+	return x->index - y->index;
+}
+
+// Fill order[] with the snapshot indices by ascending IVD (descending
+// value density), keeping snapshot order among equals.
+static inline void rq_snapshot_sort_ivd(struct rq_snapshot * snap)
+{
+	int i;
+
+	for (i = 0; i < snap->nr; i++) {
+		snap->keys[i].ivd = snap->ivd[i];
+		snap->keys[i].index = i;
+	}
+
+	sort(snap->keys, snap->nr, sizeof(*snap->keys), snapshot_key_cmp, NULL);
+
+	for (i = 0; i < snap->nr; i++)
+		snap->order[i] = snap->keys[i].index;
+}
+
+#endif
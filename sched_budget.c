@@ -0,0 +1,41 @@
+/* chronos/sched_budget.c
+ *
+ * Time budget for utility accrual decisions in ChronOS (see
+ * sched_budget.h)
+ *
+ * Author(s)
+ *	- Ben Weinstein-Raun, bwr@vt.edu
+ *
+ * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
+ */
+
+#include <linux/module.h>
+#include <linux/debugfs.h>
+#include <linux/fs.h>
+#include <linux/types.h>
+
+#include "sched_budget.h"
+
+u64 sched_budget_ns;
+EXPORT_SYMBOL(sched_budget_ns);
+
+static struct dentry * budget_file;
+
+static int __init sched_budget_init(void)
+{
+	// Without debugfs the budget stays 0, for none
+	budget_file = debugfs_create_u64("chronos_budget_ns", 0600, NULL,
+					 &sched_budget_ns);
+	return 0;
+}
+module_init(sched_budget_init);
+
+static void __exit sched_budget_exit(void)
+{
+	debugfs_remove_recursive(budget_file);
+}
+module_exit(sched_budget_exit);
+
+MODULE_DESCRIPTION("Decision Time Budget for ChronOS");
+MODULE_AUTHOR("Ben Weinstein-Raun <b@w-r.me>");
+MODULE_LICENSE("GPL");
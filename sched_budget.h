@@ -0,0 +1,66 @@
+/* chronos/sched_budget.h
+ *
+ * Time budget for a utility accrual decision.
+ *
+ * Under overload, DASA, DASA-ND and LBESA try task after task, and the
+ * time they take grows with the ready queue just when the tasks can least
+ * spare it. With sched_budget_ns set, a decision that has used up that
+ * many ns stops trying: DASA, DASA-ND and G-DASA run the first task of
+ * the schedule they have accepted so far, which is feasible, or the most
+ * value-dense task if it is still empty; LBESA, which only has a feasible
+ * schedule once it is done shedding, runs the most value-dense task it
+ * has not shed. Each time that happens counts in sched_stats.budget_hits.
+ *
+ * The budget bounds the search, not the pass over the ready queue that
+ * takes the snapshot or builds the graph before it, nor sorting the
+ * snapshot by IVD. Those are linear, or n log n, and cheap beside the
+ * search they feed.
+ *
+ * sched_budget_ns is 0, for no budget, until it is set through
+ *
+ *	/sys/kernel/debug/chronos_budget_ns
+ *
+ * With no budget the checks cost a compare and never read the clock.
+ *
+ * Author(s)
+ *	- Ben Weinstein-Raun, bwr@vt.edu
+ *
+ * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
+ */
+
+#ifndef _CHRONOS_SCHED_BUDGET_H
+#define _CHRONOS_SCHED_BUDGET_H
+
+#include <linux/compiler.h>
+#include <linux/kernel.h>
+#include <linux/sched.h>
+#include <linux/types.h>
+
+#include "sched_stats.h"
+
+extern u64 sched_budget_ns;
+
+struct sched_budget {
+	// sched_clock() when the decision has to stop, or U64_MAX
+	u64 end;
+};
+
+static inline void sched_budget_start(struct sched_budget * b)
+{
+	u64 ns = READ_ONCE(sched_budget_ns);
+
+	b->end = ns ? sched_clock() + ns : U64_MAX;
+}
+
+// Whether the decision is out of time, counting it if so; the caller
+// must then stop searching.
+static inline bool sched_budget_spent(struct sched_budget * b)
+{
+	if (likely(b->end == U64_MAX) || sched_clock() < b->end)
+		return false;
+
+	sched_stats_budget_hit();
+	return true;
+}
+
+#endif
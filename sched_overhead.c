@@ -0,0 +1,44 @@
+/* chronos/sched_overhead.c
+ *
+ * Scheduling overhead estimates for ChronOS (see sched_overhead.h)
+ *
+ * Author(s)
+ *	- Ben Weinstein-Raun, bwr@vt.edu
+ *
+ * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
+ */
+
+#include <linux/module.h>
+#include <linux/debugfs.h>
+#include <linux/fs.h>
+#include <linux/percpu.h>
+#include <linux/types.h>
+
+#include "sched_overhead.h"
+
+u32 sched_overhead_enabled;
+EXPORT_SYMBOL(sched_overhead_enabled);
+
+DEFINE_PER_CPU(struct sched_overhead, sched_overheads);
+EXPORT_PER_CPU_SYMBOL(sched_overheads);
+
+static struct dentry * overhead_file;
+
+static int __init sched_overhead_init(void)
+{
+	// Without debugfs nothing is charged
+	overhead_file = debugfs_create_u32("chronos_overhead", 0600, NULL,
+					   &sched_overhead_enabled);
+	return 0;
+}
+module_init(sched_overhead_init);
+
+static void __exit sched_overhead_exit(void)
+{
+	debugfs_remove_recursive(overhead_file);
+}
+module_exit(sched_overhead_exit);
+
+MODULE_DESCRIPTION("Scheduling Overhead Estimates for ChronOS");
+MODULE_AUTHOR("Ben Weinstein-Raun <b@w-r.me>");
+MODULE_LICENSE("GPL");
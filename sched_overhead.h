@@ -0,0 +1,114 @@
+/* chronos/sched_overhead.h
+ *
+ * Scheduling overhead in the feasibility tests of the utility accrual
+ * schedulers.
+ *
+ * DASA, DASA-ND, LBESA and G-DASA call a schedule feasible if its tasks,
+ * run back to back from now, each finish by their deadlines. Running a
+ * task takes more than its remaining time, though: a decision to pick it
+ * and a context switch to it. Under load, when there are many tasks and
+ * little slack, a schedule that only just fits on paper misses.
+ *
+ * With sched_overhead_enabled set, each CPU keeps smoothed estimates of
+ * what a decision and a context switch cost on it, as TCP does for round
+ * trip times: a moving average over the last 2^SCHED_OVERHEAD_SHIFT or
+ * so samples and a moving mean deviation. The feasibility tests then
+ * charge every task in a schedule the average plus four deviations of
+ * each, which few samples go over, on top of its remaining time (see
+ * rq_snapshot_reset() and dasa_graph_build()). The schedulers shed tasks
+ * that the overhead would make miss, instead of finding out at their
+ * deadlines. Value densities are left as they were.
+ *
+ * sched_trace_decision() times the local schedulers' decisions, and
+ * G-DASA times its own. The core calls sched_overhead_switch() with the
+ * time from a decision to the task it picked running, when that is a
+ * different task from before.
+ *
+ * The estimates belong to one CPU and are only touched by it, with its
+ * runqueue locked. sched_overhead_enabled is 0, for no charge and no
+ * timing, until it is set through
+ *
+ *	/sys/kernel/debug/chronos_overhead
+ *
+ * Author(s)
+ *	- Ben Weinstein-Raun, bwr@vt.edu
+ *
+ * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
+ */
+
+#ifndef _CHRONOS_SCHED_OVERHEAD_H
+#define _CHRONOS_SCHED_OVERHEAD_H
+
+#include <linux/compiler.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/types.h>
+
+// The average moves 1/2^SCHED_OVERHEAD_SHIFT of the way to each sample,
+// the deviation twice as fast
+#define SCHED_OVERHEAD_SHIFT	3
+
+struct sched_overhead {
+	// Smoothed cost and mean deviation, in ns, or 0 before any sample
+	s64 decision;
+	s64 decision_dev;
+	s64 csw;
+	s64 csw_dev;
+};
+
+extern u32 sched_overhead_enabled;
+DECLARE_PER_CPU(struct sched_overhead, sched_overheads);
+
+static inline bool sched_overhead_on(void)
+{
+	return unlikely(READ_ONCE(sched_overhead_enabled));
+}
+
+static inline void sched_overhead_sample(s64 * avg, s64 * dev, s64 ns)
+{
+	s64 err = ns - *avg;
+
+	if (*avg == 0) {
+		*avg = ns;
+		*dev = ns / 2;
+		return;
+	}
+
+	*avg += err >> SCHED_OVERHEAD_SHIFT;
+	*dev += ((err < 0 ? -err : err) - *dev) >> (SCHED_OVERHEAD_SHIFT - 1);
+}
+
+// When a decision starts, for sched_overhead_decision(); 0 if not timing
+static inline u64 sched_overhead_start(void)
+{
+	return sched_overhead_on() ? sched_clock() : 0;
+}
+
+static inline void sched_overhead_decision(u64 start)
+{
+	struct sched_overhead * o = this_cpu_ptr(&sched_overheads);
+
+	if (start)
+		sched_overhead_sample(&o->decision, &o->decision_dev,
+				      sched_clock() - start);
+}
+
+static inline void sched_overhead_switch(u64 ns)
+{
+	struct sched_overhead * o = this_cpu_ptr(&sched_overheads);
+
+	if (sched_overhead_on())
+		sched_overhead_sample(&o->csw, &o->csw_dev, ns);
+}
+
+// What to add to each task's remaining time in a feasibility test, in ns
+static inline s64 sched_overhead_charge(void)
+{
+	struct sched_overhead * o = this_cpu_ptr(&sched_overheads);
+
+	if (!sched_overhead_on())
+		return 0;
+	return o->decision + 4 * o->decision_dev + o->csw + 4 * o->csw_dev;
+}
+
+#endif
@@ -0,0 +1,89 @@
+/* chronos/sched_stats.c
+ *
+ * Per-CPU scheduling statistics for ChronOS (see sched_stats.h)
+ *
+ * Author(s)
+ *	- Ben Weinstein-Raun, bwr@vt.edu
+ *
+ * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
+ */
+
+#include <linux/module.h>
+#include <linux/chronos_types.h>
+#include <linux/debugfs.h>
+#include <linux/errno.h>
+#include <linux/fs.h>
+#include <linux/percpu.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+#include <asm/barrier.h>
+#include <asm/processor.h>
+
+#include "sched_stats.h"
+
+DEFINE_PER_CPU(struct sched_stats_cpu, sched_stats_cpus);
+EXPORT_PER_CPU_SYMBOL(sched_stats_cpus);
+
+static struct dentry * stats_file;
+
+// A consistent snapshot of cpu's counters
+void sched_stats_read(int cpu, struct sched_stats * stats)
+{
+	struct sched_stats_cpu * c = &per_cpu(sched_stats_cpus, cpu);
+	unsigned int seq;
+
+	do {
+		while ((seq = READ_ONCE(c->seq)) & 1)
+			cpu_relax();
+		smp_rmb();
+		*stats = c->stats;
+		smp_rmb();
+	} while (READ_ONCE(c->seq) != seq);
+}
+EXPORT_SYMBOL(sched_stats_read);
+
+static ssize_t stats_read(struct file * file, char __user * buf,
+			  size_t count, loff_t * ppos)
+{
+	struct sched_stats * snap;
+	size_t size = 0;
+	ssize_t ret;
+	int cpu;
+
+	snap = kmalloc(NR_CPUS * sizeof(*snap), GFP_KERNEL);
+	if (snap == NULL)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu)
+		sched_stats_read(cpu, &snap[size++]);
+
+	ret = simple_read_from_buffer(buf, count, ppos, snap,
+				      size * sizeof(*snap));
+	kfree(snap);
+	return ret;
+}
+
+static const struct file_operations stats_fops = {
+	.owner = THIS_MODULE,
+	.read = stats_read,
+	.llseek = default_llseek,
+};
+
+static int __init sched_stats_init(void)
+{
+	// Without debugfs the counters can still be read in-kernel
+	stats_file = debugfs_create_file("chronos_stats", 0444, NULL, NULL,
+					 &stats_fops);
+	return 0;
+}
+module_init(sched_stats_init);
+
+static void __exit sched_stats_exit(void)
+{
+	debugfs_remove_recursive(stats_file);
+}
+module_exit(sched_stats_exit);
+
+MODULE_DESCRIPTION("Scheduling Statistics for ChronOS");
+MODULE_AUTHOR("Ben Weinstein-Raun <b@w-r.me>");
+MODULE_LICENSE("GPL");
@@ -0,0 +1,136 @@
+/* chronos/sched_stats.h
+ *
+ * Per-CPU scheduling statistics.
+ *
+ * Every CPU counts the jobs released on it, the jobs that met or missed
+ * their deadlines, the jobs aborted, the utility accrued by the jobs that
+ * met their deadlines, how often the scheduler ran, how often its
+ * decision preempted the task that was running and how often it ran out
+ * of its time budget (see sched_budget.h).
+ *
+ * Only a CPU's own events touch its counters, with preemption off, so
+ * updating them takes no lock and no atomic operation. A sequence count
+ * lets readers on other CPUs take a consistent snapshot without holding
+ * the CPU up. The counters are always on; they cost a few stores to a
+ * line the CPU already owns.
+ *
+ * The core calls sched_stats_release(), sched_stats_complete() and
+ * sched_stats_leave() as jobs come and go, and the schedulers call
+ * sched_stats_decision() (sched_trace_decision() does it for the local
+ * schedulers). Snapshots of every possible CPU are read in binary from
+ *
+ *	/sys/kernel/debug/chronos_stats		struct sched_stats per CPU
+ *
+ * and read_stats.py turns them into CSV.
+ *
+ * Author(s)
+ *	- Ben Weinstein-Raun, bwr@vt.edu
+ *
+ * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
+ */
+
+#ifndef _CHRONOS_SCHED_STATS_H
+#define _CHRONOS_SCHED_STATS_H
+
+#include <linux/compiler.h>
+#include <linux/percpu.h>
+#include <linux/types.h>
+#include <linux/chronos_types.h>
+#include <linux/chronos_sched.h>
+#include <asm/barrier.h>
+
+struct sched_stats {
+	u64 released;
+	u64 met;
+	u64 missed;
+	u64 aborted;
+	u64 utility;		// of the jobs that met their deadlines
+	u64 preemptions;
+	u64 decisions;
+	u64 budget_hits;	// decisions cut short (see sched_budget.h)
+};
+
+struct sched_stats_cpu {
+	// Odd while the counters are being updated
+	unsigned int seq;
+	// What the last decision picked, while it is still ready
+	struct rt_info * curr;
+	struct sched_stats stats;
+};
+
+DECLARE_PER_CPU(struct sched_stats_cpu, sched_stats_cpus);
+
+void sched_stats_read(int cpu, struct sched_stats * stats);
+
+static inline struct sched_stats_cpu * sched_stats_begin(void)
+{
+	struct sched_stats_cpu * c = this_cpu_ptr(&sched_stats_cpus);
+
+	WRITE_ONCE(c->seq, c->seq + 1);
+	smp_wmb();
+	return c;
+}
+
+static inline void sched_stats_end(struct sched_stats_cpu * c)
+{
+	smp_wmb();
+	WRITE_ONCE(c->seq, c->seq + 1);
+}
+
+static inline void sched_stats_release(struct rt_info * task)
+{
+	struct sched_stats_cpu * c = sched_stats_begin();
+
+	c->stats.released++;
+	sched_stats_end(c);
+}
+
+// A job that was picked last no longer preempts anything by going
+static inline void sched_stats_leave(struct rt_info * task)
+{
+	struct sched_stats_cpu * c = this_cpu_ptr(&sched_stats_cpus);
+
+	if (c->curr == task)
+		c->curr = NULL;
+
+	if (check_task_aborted(task)) {
+		c = sched_stats_begin();
+		c->stats.aborted++;
+		sched_stats_end(c);
+	}
+}
+
+// task's job has finished; call before sched_stats_leave()
+static inline void sched_stats_complete(struct rt_info * task, bool met)
+{
+	struct sched_stats_cpu * c = sched_stats_begin();
+
+	if (met) {
+		c->stats.met++;
+		c->stats.utility += task->max_util;
+	} else {
+		c->stats.missed++;
+	}
+	sched_stats_end(c);
+}
+
+static inline void sched_stats_budget_hit(void)
+{
+	struct sched_stats_cpu * c = sched_stats_begin();
+
+	c->stats.budget_hits++;
+	sched_stats_end(c);
+}
+
+static inline void sched_stats_decision(struct rt_info * task)
+{
+	struct sched_stats_cpu * c = sched_stats_begin();
+
+	c->stats.decisions++;
+	if (c->curr != NULL && c->curr != task)
+		c->stats.preemptions++;
+	c->curr = task;
+	sched_stats_end(c);
+}
+
+#endif
@@ -0,0 +1,226 @@
+/* chronos/sched_trace.c
+ *
+ * Per-CPU scheduling decision trace for ChronOS (see sched_trace.h)
+ *
+ * Author(s)
+ *	- Ben Weinstein-Raun, bwr@vt.edu
+ *
+ * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
+ */
+
+#include <linux/module.h>
+#include <linux/chronos_types.h>
+#include <linux/chronos_sched.h>
+#include <linux/debugfs.h>
+#include <linux/errno.h>
+#include <linux/fs.h>
+#include <linux/mutex.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+#include <asm/barrier.h>
+
+#include "sched_trace.h"
+
+#define SCHED_TRACE_MASK	(SCHED_TRACE_SIZE - 1)
+
+struct sched_trace_ring {
+	struct sched_trace_event * events;
+	// Records written, only ever advanced by the ring's own CPU
+	u64 head;
+	// Records read, only ever advanced by a reader holding trace_mutex
+	u64 tail;
+};
+
+u32 sched_trace_enabled;
+EXPORT_SYMBOL(sched_trace_enabled);
+
+DEFINE_PER_CPU(struct sched_trace_pending, sched_trace_pending);
+EXPORT_PER_CPU_SYMBOL(sched_trace_pending);
+
+static DEFINE_PER_CPU(struct sched_trace_ring, trace_rings);
+static DEFINE_MUTEX(trace_mutex);
+static u64 trace_lost;
+
+static struct dentry * trace_dir;
+
+void sched_trace_begin(int nr_ready)
+{
+	struct sched_trace_pending * p = this_cpu_ptr(&sched_trace_pending);
+
+	p->nr_ready = nr_ready;
+	p->shed = 0;
+	p->checks = 0;
+	p->start = sched_clock();
+}
+EXPORT_SYMBOL(sched_trace_begin);
+
+// Called with preemption off, so nothing else writes this CPU's ring
+void sched_trace_end(int sched_id, struct rt_info * task)
+{
+	struct sched_trace_pending * p = this_cpu_ptr(&sched_trace_pending);
+	struct sched_trace_ring * ring = this_cpu_ptr(&trace_rings);
+	struct timespec now = CURRENT_TIME;
+	struct sched_trace_event * e;
+	u64 head = ring->head;
+
+	if (ring->events == NULL)
+		return;
+
+	e = &ring->events[head & SCHED_TRACE_MASK];
+	e->latency = sched_clock() - p->start;
+	e->time = timespec_to_ns(&now);
+	e->deadline = task ? timespec_to_ns(&task->deadline) : 0;
+	e->nr_ready = p->nr_ready;
+	e->shed = p->shed;
+	e->checks = p->checks;
+	e->sched_id = sched_id;
+	e->cpu = smp_processor_id();
+	e->reserved = 0;
+
+	// The record must be complete before a reader can see it
+	smp_wmb();
+	WRITE_ONCE(ring->head, head + 1);
+}
+EXPORT_SYMBOL(sched_trace_end);
+
+/*
+ * Copy up to nr of the oldest unread records from cpu's ring, and mark
+ * them read. Records the writer overwrote before or while they were
+ * copied are dropped and counted as lost. Returns how many were copied.
+ */
+int sched_trace_consume(int cpu, struct sched_trace_event * events, int nr)
+{
+	struct sched_trace_ring * ring = &per_cpu(trace_rings, cpu);
+	u64 head, tail, valid;
+	int i, copied;
+
+	if (ring->events == NULL)
+		return 0;
+
+	mutex_lock(&trace_mutex);
+
+	head = READ_ONCE(ring->head);
+	smp_rmb();
+
+	tail = ring->tail;
+	if (head - tail > SCHED_TRACE_SIZE) {
+		trace_lost += head - tail - SCHED_TRACE_SIZE;
+		tail = head - SCHED_TRACE_SIZE;
+	}
+
+	copied = min_t(u64, nr, head - tail);
+	for (i = 0; i < copied; i++)
+		events[i] = ring->events[(tail + i) & SCHED_TRACE_MASK];
+
+	// Anything the writer has since started overwriting may be torn.
+	// It is writing record head, over record head - SCHED_TRACE_SIZE.
+	smp_rmb();
+	head = READ_ONCE(ring->head);
+	valid = head + 1 > SCHED_TRACE_SIZE ? head + 1 - SCHED_TRACE_SIZE : 0;
+	if (valid > tail) {
+		i = min_t(u64, valid - tail, copied);
+		trace_lost += i;
+		memmove(events, events + i, (copied - i) * sizeof(*events));
+		copied -= i;
+		tail += i;
+	}
+
+	ring->tail = tail + copied;
+	mutex_unlock(&trace_mutex);
+
+	return copied;
+}
+EXPORT_SYMBOL(sched_trace_consume);
+
+u64 sched_trace_lost(void)
+{
+	return READ_ONCE(trace_lost);
+}
+EXPORT_SYMBOL(sched_trace_lost);
+
+static ssize_t trace_read(struct file * file, char __user * buf,
+			  size_t count, loff_t * ppos)
+{
+	struct sched_trace_event events[16];
+	int cpu = (long) file->private_data;
+	size_t done = 0;
+	int nr;
+
+	while (count - done >= sizeof(events[0])) {
+		nr = min_t(size_t, ARRAY_SIZE(events),
+			   (count - done) / sizeof(events[0]));
+		nr = sched_trace_consume(cpu, events, nr);
+		if (nr == 0)
+			break;
+		if (copy_to_user(buf + done, events, nr * sizeof(events[0])))
+			return -EFAULT;
+		done += nr * sizeof(events[0]);
+	}
+
+	*ppos += done;
+	return done;
+}
+
+static const struct file_operations trace_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.read = trace_read,
+	.llseek = no_llseek,
+};
+
+static void sched_trace_free(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		kfree(per_cpu(trace_rings, cpu).events);
+		per_cpu(trace_rings, cpu).events = NULL;
+	}
+}
+
+static int __init sched_trace_init(void)
+{
+	struct sched_trace_ring * ring;
+	char name[16];
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		ring = &per_cpu(trace_rings, cpu);
+		ring->events = kzalloc(SCHED_TRACE_SIZE * sizeof(*ring->events),
+				       GFP_KERNEL);
+		if (ring->events == NULL) {
+			sched_trace_free();
+			return -ENOMEM;
+		}
+	}
+
+	// Without debugfs the rings can still be read in-kernel
+	trace_dir = debugfs_create_dir("chronos", NULL);
+	if (trace_dir == NULL)
+		return 0;
+
+	debugfs_create_u32("enable", 0600, trace_dir, &sched_trace_enabled);
+	debugfs_create_u64("lost", 0400, trace_dir, &trace_lost);
+	for_each_possible_cpu(cpu) {
+		snprintf(name, sizeof(name), "cpu%d", cpu);
+		debugfs_create_file(name, 0400, trace_dir, (void *) (long) cpu,
+				    &trace_fops);
+	}
+
+	return 0;
+}
+module_init(sched_trace_init);
+
+static void __exit sched_trace_exit(void)
+{
+	WRITE_ONCE(sched_trace_enabled, 0);
+	debugfs_remove_recursive(trace_dir);
+	sched_trace_free();
+}
+module_exit(sched_trace_exit);
+
+MODULE_DESCRIPTION("Scheduling Decision Trace for ChronOS");
+MODULE_AUTHOR("Ben Weinstein-Raun <b@w-r.me>");
+MODULE_LICENSE("GPL");
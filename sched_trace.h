@@ -0,0 +1,134 @@
+/* chronos/sched_trace.h
+ *
+ * Per-CPU trace of scheduling decisions.
+ *
+ * Printing from the scheduler costs more than most decisions do, and
+ * skews whatever is being measured. Instead, when tracing is on, each
+ * decision appends one fixed-size record to a ring on the CPU that made
+ * it: when it was made, how long it took, what it picked, how many tasks
+ * were ready, how many it shed and how many feasibility checks it ran.
+ *
+ * Each ring has one writer, its own CPU, so appending takes no lock and
+ * no atomic operation. Readers never hold the writer up: a reader that
+ * falls behind loses the oldest records, and is told how many. The rings
+ * are read in binary from debugfs, one file per CPU:
+ *
+ *	/sys/kernel/debug/chronos/enable	write 1 to start tracing
+ *	/sys/kernel/debug/chronos/cpuN		struct sched_trace_event records
+ *	/sys/kernel/debug/chronos/lost		records overwritten before read
+ *
+ * Reading a cpuN file consumes what it returns. read_trace.py turns the
+ * records into CSV.
+ *
+ * When tracing is off, a decision pays one predictable branch, and the
+ * counting calls below one more each.
+ *
+ * Author(s)
+ *	- Ben Weinstein-Raun, bwr@vt.edu
+ *
+ * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
+ */
+
+#ifndef _CHRONOS_SCHED_TRACE_H
+#define _CHRONOS_SCHED_TRACE_H
+
+#include <linux/compiler.h>
+#include <linux/list.h>
+#include <linux/percpu.h>
+#include <linux/types.h>
+#include <linux/chronos_types.h>
+
+#include "sched_overhead.h"
+#include "sched_stats.h"
+
+// Records per CPU; a power of two
+#define SCHED_TRACE_SIZE	1024
+
+struct sched_trace_event {
+	u64 time;		// CURRENT_TIME at the decision, in ns
+	u64 deadline;		// absolute deadline of the job picked, or 0
+	u32 latency;		// ns spent deciding
+	u32 nr_ready;
+	u32 shed;		// tasks taken out of the tentative schedule
+	u32 checks;		// feasibility checks
+	u16 sched_id;
+	u16 cpu;
+	u32 reserved;
+};
+
+// The decision in progress on a CPU
+struct sched_trace_pending {
+	u64 start;
+	u32 nr_ready;
+	u32 shed;
+	u32 checks;
+};
+
+extern u32 sched_trace_enabled;
+DECLARE_PER_CPU(struct sched_trace_pending, sched_trace_pending);
+
+void sched_trace_begin(int nr_ready);
+void sched_trace_end(int sched_id, struct rt_info * task);
+int sched_trace_consume(int cpu, struct sched_trace_event * events, int nr);
+u64 sched_trace_lost(void);
+
+static inline bool sched_trace_on(void)
+{
+	return unlikely(READ_ONCE(sched_trace_enabled));
+}
+
+static inline void sched_trace_shed(int nr)
+{
+	if (sched_trace_on())
+		this_cpu_ptr(&sched_trace_pending)->shed += nr;
+}
+
+static inline void sched_trace_check(void)
+{
+	if (sched_trace_on())
+		this_cpu_ptr(&sched_trace_pending)->checks++;
+}
+
+// For schedulers that keep their own queue and know its size
+static inline void sched_trace_ready(int nr)
+{
+	if (sched_trace_on())
+		this_cpu_ptr(&sched_trace_pending)->nr_ready = nr;
+}
+
+/*
+ * Make a local scheduling decision with decide(), counting it in the
+ * CPU's statistics, timing it for sched_overhead.h if that is on and
+ * tracing it if tracing is on. The ready queue is only counted when it
+ * is.
+ */
+static inline struct rt_info *
+sched_trace_decision(int sched_id, struct list_head * head, int flags,
+		     struct rt_info * (*decide)(struct list_head * head, int flags))
+{
+	struct rt_info * task;
+	struct list_head * pos;
+	int nr = 0;
+	u64 start;
+
+	if (!sched_trace_on()) {
+		start = sched_overhead_start();
+		task = decide(head, flags);
+		sched_overhead_decision(start);
+		sched_stats_decision(task);
+		return task;
+	}
+
+	list_for_each(pos, head)
+		nr++;
+
+	sched_trace_begin(nr);
+	start = sched_overhead_start();
+	task = decide(head, flags);
+	sched_overhead_decision(start);
+	sched_trace_end(sched_id, task);
+	sched_stats_decision(task);
+	return task;
+}
+
+#endif
@@ -0,0 +1,81 @@
+/* chronos/sched_variant.h
+ *
+ * Decisions specialized on the scheduler flags.
+ *
+ * The flags a scheduler is called with only change when sched_test_app
+ * sets the scheduler, but the utility accrual schedulers tested them for
+ * every task in every decision, through check_task_failure(), which also
+ * read the clock each time. Instead, a scheduler writes its decision once
+ * as an __always_inline function whose last argument, variant, is a
+ * compile-time constant holding the flags it specializes on, and
+ * DEFINE_SCHED_VARIANTS() makes a copy for each combination. Tests of
+ * variant fold away in each copy, so the loops over the ready tasks carry
+ * no flag tests at all. sched_variant() picks the copy for the flags a
+ * decision is made with, which costs one indexed load per decision; the
+ * copy is what gets passed to sched_trace_decision().
+ *
+ * SCHED_FLAG_HUA is the only flag that changes what a decision does for
+ * each task, so it is the only one specialized on. The others stay
+ * ordinary tests: SCHED_FLAG_PI and SCHED_FLAG_NO_DEADLOCKS are acted on
+ * in the lock hooks and the core, never in these decisions, and
+ * SCHED_FLAG_NO_CACHE is tested once per decision, in
+ * decision_cache_set(). Aborting is not a flag but the per-task ABORTED
+ * bit, which sched_task_failed() has to test for every task whatever
+ * the variant.
+ *
+ * Author(s)
+ *	- Ben Weinstein-Raun, bwr@vt.edu
+ *
+ * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
+ */
+
+#ifndef _CHRONOS_SCHED_VARIANT_H
+#define _CHRONOS_SCHED_VARIANT_H
+
+#include <linux/compiler.h>
+#include <linux/list.h>
+#include <linux/time.h>
+#include <linux/types.h>
+#include <linux/chronos_types.h>
+#include <linux/chronos_sched.h>
+
+#define SCHED_VARIANT_FLAGS	SCHED_FLAG_HUA
+
+typedef struct rt_info * (* sched_decide_t)(struct list_head * head, int flags);
+
+#define DEFINE_SCHED_VARIANTS(name, decide)					\
+static struct rt_info * name##_plain(struct list_head * head, int flags)	\
+{										\
+	return decide(head, flags, 0);						\
+}										\
+static struct rt_info * name##_hua(struct list_head * head, int flags)		\
+{										\
+	return decide(head, flags, SCHED_FLAG_HUA);				\
+}										\
+static const sched_decide_t name[SCHED_VARIANT_FLAGS + 1] = {			\
+	[0] = name##_plain,							\
+	[SCHED_FLAG_HUA] = name##_hua,						\
+}
+
+#define sched_variant(name, flags)	((name)[(flags) & SCHED_VARIANT_FLAGS])
+
+/*
+ * check_task_failure() for a decision made at now: whether task has been
+ * aborted or, with SCHED_FLAG_HUA in variant, has missed its deadline,
+ * in which case it is aborted here.
+ */
+static __always_inline bool sched_task_failed(struct rt_info * task, s64 now,
+					      const int variant)
+{
+	if (task_check_flag(task, ABORTED))
+		return true;
+
+	if ((variant & SCHED_FLAG_HUA) && timespec_to_ns(&task->deadline) < now) {
+		abort_thread(task);
+		return true;
+	}
+
+	return false;
+}
+
+#endif
@@ -0,0 +1,256 @@
+/* chronos/slack_tree.h
+ *
+ * Deadline-ordered AVL tree shared by the utility accrual schedulers.
+ *
+ * Each node caches, for its subtree, the total remaining execution time
+ * and the smallest slack (deadline minus the execution of everything up
+ * to and including that task). The whole schedule is feasible from time
+ * `now` exactly when the root's slack is at least `now`, so inserting a
+ * task, removing one and checking feasibility are all O(log n) instead of
+ * a walk over the whole schedule.
+ *
+ * Nodes are handed out from a per-CPU pool that only ever grows, so a
+ * scheduler doesn't allocate once its ready queue has reached its
+ * usual size.
+ *
+ * Author(s)
+ *	- Ben Weinstein-Raun, bwr@vt.edu
+ *
+ * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
+ */
+
+#ifndef _CHRONOS_SLACK_TREE_H
+#define _CHRONOS_SLACK_TREE_H
+
+#include <linux/types.h>
+#include <linux/time.h>
+#include <linux/slab.h>
+#include <linux/chronos_types.h>
+
+struct slack_node {
+	struct slack_node * child[2];
+	struct rt_info * task;
+
+	// Ordering key, ties broken by seq (newest first)
+	s64 key;
+	unsigned long seq;
+
+	s64 deadline;
+	s64 exec;
+
+	// Subtree aggregates
+	s64 sum;
+	s64 slack;
+	int height;
+};
+
+struct slack_tree {
+	struct slack_node * root;
+	unsigned long seq;
+};
+
+struct slack_pool {
+	struct slack_node * nodes;
+	int size;
+};
+
+static inline void slack_tree_init(struct slack_tree * tree)
+{
+	tree->root = NULL;
+	tree->seq = ULONG_MAX;
+}
+
+static inline bool slack_tree_empty(struct slack_tree * tree)
+{
+	return tree->root == NULL;
+}
+
+static inline void __slack_node_init(struct slack_node * node, struct rt_info * task,
+				     s64 key, s64 deadline, s64 exec)
+{
+	node->task = task;
+	node->key = key;
+	node->deadline = deadline;
+	node->exec = exec;
+}
+
+// Ordered by key, which is the deadline unless the caller wants
+// something else (DASA's tightened deadlines, for example).
+static inline void slack_node_init(struct slack_node * node, struct rt_info * task,
+				   struct timespec * key)
+{
+	__slack_node_init(node, task, timespec_to_ns(key),
+			  timespec_to_ns(&task->deadline),
+			  timespec_to_ns(&task->left));
+}
+
+static inline struct slack_node * slack_pool_get(struct slack_pool * pool, int size)
+{
+	struct slack_node * nodes;
+
+	if (pool->size < size) {
+		nodes = krealloc(pool->nodes, size * sizeof(*nodes), GFP_ATOMIC);
+		if (nodes == NULL)
+			return NULL;
+		pool->nodes = nodes;
+		pool->size = size;
+	}
+
+	return pool->nodes;
+}
+
+static inline void slack_pool_free(struct slack_pool * pool)
+{
+	kfree(pool->nodes);
+	pool->nodes = NULL;
+	pool->size = 0;
+}
+
+static inline int slack_height(struct slack_node * node)
+{
+	return node ? node->height : 0;
+}
+
+static inline bool slack_before(struct slack_node * a, struct slack_node * b)
+{
+	return a->key < b->key || (a->key == b->key && a->seq < b->seq);
+}
+
+static inline void slack_update(struct slack_node * node)
+{
+	struct slack_node * l = node->child[0], * r = node->child[1];
+	s64 through = (l ? l->sum : 0) + node->exec;
+
+	node->slack = node->deadline - through;
+	if (l && l->slack < node->slack)
+		node->slack = l->slack;
+	if (r && r->slack - through < node->slack)
+		node->slack = r->slack - through;
+
+	node->sum = through + (r ? r->sum : 0);
+	node->height = 1 + max(slack_height(l), slack_height(r));
+}
+
+// Rotate so that node's child on side !dir becomes the subtree root
+static inline struct slack_node * slack_rotate(struct slack_node * node, int dir)
+{
+	struct slack_node * pivot = node->child[!dir];
+
+	node->child[!dir] = pivot->child[dir];
+	pivot->child[dir] = node;
+	slack_update(node);
+	slack_update(pivot);
+	return pivot;
+}
+
+static struct slack_node * slack_balance(struct slack_node * node)
+{
+	int dir, diff;
+
+	slack_update(node);
+	diff = slack_height(node->child[0]) - slack_height(node->child[1]);
+	if (diff > -2 && diff < 2)
+		return node;
+
+	// dir is the tall side
+	dir = diff < 0;
+	if (slack_height(node->child[dir]->child[!dir]) >
+	    slack_height(node->child[dir]->child[dir]))
+		node->child[dir] = slack_rotate(node->child[dir], dir);
+
+	return slack_rotate(node, !dir);
+}
+
+static struct slack_node * __slack_insert(struct slack_node * root,
+					  struct slack_node * node)
+{
+	int dir;
+
+	if (root == NULL) {
+		node->child[0] = node->child[1] = NULL;
+		slack_update(node);
+		return node;
+	}
+
+	dir = !slack_before(node, root);
+	root->child[dir] = __slack_insert(root->child[dir], node);
+	return slack_balance(root);
+}
+
+static struct slack_node * slack_erase_min(struct slack_node * root,
+					   struct slack_node ** min)
+{
+	if (root->child[0] == NULL) {
+		*min = root;
+		return root->child[1];
+	}
+
+	root->child[0] = slack_erase_min(root->child[0], min);
+	return slack_balance(root);
+}
+
+static struct slack_node * __slack_erase(struct slack_node * root,
+					 struct slack_node * node)
+{
+	struct slack_node * min;
+	int dir;
+
+	if (root == node) {
+		if (node->child[1] == NULL)
+			return node->child[0];
+
+		node->child[1] = slack_erase_min(node->child[1], &min);
+		min->child[0] = node->child[0];
+		min->child[1] = node->child[1];
+		return slack_balance(min);
+	}
+
+	dir = !slack_before(node, root);
+	root->child[dir] = __slack_erase(root->child[dir], node);
+	return slack_balance(root);
+}
+
+// Insert node with the seq it already has, e.g. to put a node that was
+// just erased back exactly where it was.
+static inline void slack_reinsert(struct slack_tree * tree, struct slack_node * node)
+{
+	tree->root = __slack_insert(tree->root, node);
+}
+
+// Insert node ahead of any nodes that already have the same key
+static inline void slack_insert(struct slack_tree * tree, struct slack_node * node)
+{
+	node->seq = tree->seq--;
+	slack_reinsert(tree, node);
+}
+
+static inline void slack_erase(struct slack_tree * tree, struct slack_node * node)
+{
+	tree->root = __slack_erase(tree->root, node);
+}
+
+// Would every task in the tree, run back to back from now in key order,
+// finish by its deadline?
+static inline bool slack_feasible(struct slack_tree * tree, s64 now)
+{
+	return tree->root == NULL || tree->root->slack >= now;
+}
+
+// The latest time the whole schedule can start and still be feasible
+static inline s64 slack_latest_start(struct slack_tree * tree)
+{
+	return tree->root ? tree->root->slack : S64_MAX;
+}
+
+static inline struct slack_node * slack_first(struct slack_tree * tree)
+{
+	struct slack_node * node = tree->root;
+
+	if (node == NULL)
+		return NULL;
+	while (node->child[0] != NULL)
+		node = node->child[0];
+	return node;
+}
+
+#endif
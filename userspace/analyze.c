@@ -0,0 +1,332 @@
+/* userspace/analyze.c
+ *
+ * Offline schedulability analysis of a sched_test_app task file, using
+ * the exact tests in analysis.h instead of running the tasks.
+ *
+ * Each CPU usage point scales every task's usage, and its critical
+ * sections, by usage/100 as sched_test_app -c does, then checks each
+ * CPU's tasks under the scheduler given with -s: response time analysis
+ * for RMA (with priority inheritance blocking) and ICPP (with ceiling
+ * blocking), in rate monotonic order as both schedule, and processor
+ * demand analysis for EDF and for HYBRID, DASA, DASA_ND and LBESA, which
+ * schedule in deadline order whenever that meets every deadline. Other
+ * schedulers, such as HVDF, which orders by value density, have no test
+ * here and are refused. The points of a sweep are spread over threads.
+ *
+ * The Locks column, if there is one, lists the locks a task takes and
+ * how long it holds each, in us, as lock:us pairs separated by commas,
+ * e.g. 0:500,2:120. Anything else there (such as 0) means no locks.
+ *
+ * A Deadline column after it, if there is one, gives the task's relative
+ * deadline in us, which can be shorter than its period but not longer.
+ * Without one, the deadline is the period. Only analyze reads it;
+ * sched_test_app and sim always use implicit deadlines.
+ *
+ * Prints one CSV line per point: scheduler, usage as a fraction (as in
+ * results*.csv), 1 if schedulable, and if not, the first CPU found to
+ * miss a deadline and, for the fixed priority tests, the line of the
+ * task that misses it (0 otherwise). The exit status is 1 if any point
+ * is not schedulable.
+ *
+ * usage: analyze [-s scheduler] [-c min[:max[:step]]] [-j threads] taskfile
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include "chronos.h"
+#include "../analysis.h"
+
+#define MAX_LINE	1024
+#define MAX_TASK_LOCKS	16
+
+struct task {
+	int line;
+	int cpu;
+	u64 period;
+	u64 deadline;
+	u64 usage;
+	int nr_cs;
+	struct analysis_cs cs[MAX_TASK_LOCKS];
+};
+
+struct result {
+	int usage;
+	int schedulable;
+	int cpu;
+	int line;
+};
+
+static struct rt_sched_local *sched;
+static struct task *tasks;
+static int nr_tasks, nr_locks, nr_cpus;
+static struct result *results;
+static int nr_points, next_point;
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-s scheduler] [-c min[:max[:step]]] "
+		"[-j threads] taskfile\n", prog);
+	exit(2);
+}
+
+// Parse a "T cpu group wss period usage utility [locks [deadline]]" line
+static int parse_task(char *text, struct task *t)
+{
+	long long period, use;
+	char *field, *deadline, *save, *p;
+	int group, wss, i;
+
+	memset(t, 0, sizeof(*t));
+	if (sscanf(text, "T %d %d %d %lld %lld", &t->cpu, &group, &wss,
+		   &period, &use) != 5 || period <= 0 || use < 0 || t->cpu < 0)
+		return -1;
+	t->period = t->deadline = period;
+	t->usage = use;
+
+	field = strtok_r(text, " \t\n", &save);
+	for (i = 0; field != NULL && i < 7; i++)
+		field = strtok_r(NULL, " \t\n", &save);
+	deadline = field ? strtok_r(NULL, " \t\n", &save) : NULL;
+	if (deadline != NULL) {
+		if (sscanf(deadline, "%lld", &use) != 1 || use <= 0 ||
+		    use > period)
+			return -1;
+		t->deadline = use;
+	}
+	if (field == NULL || strchr(field, ':') == NULL)
+		return 0;
+
+	for (p = strtok_r(field, ",", &save); p != NULL;
+	     p = strtok_r(NULL, ",", &save)) {
+		if (t->nr_cs == MAX_TASK_LOCKS)
+			return -1;
+		if (sscanf(p, "%d:%lld", &t->cs[t->nr_cs].lock, &use) != 2 ||
+		    t->cs[t->nr_cs].lock < 0 || use < 0)
+			return -1;
+		t->cs[t->nr_cs].length = use;
+		nr_locks = max(nr_locks, t->cs[t->nr_cs].lock + 1);
+		t->nr_cs++;
+	}
+	return 0;
+}
+
+static void read_tasks(const char *path)
+{
+	char text[MAX_LINE];
+	int line = 0, declared = 0;
+	FILE *f = fopen(path, "r");
+
+	if (f == NULL) {
+		perror(path);
+		exit(2);
+	}
+
+	while (fgets(text, sizeof(text), f)) {
+		line++;
+		if (text[0] == 'L') {
+			sscanf(text, "L %d", &declared);
+			continue;
+		}
+		if (text[0] != 'T')
+			continue;
+
+		tasks = realloc(tasks, (nr_tasks + 1) * sizeof(*tasks));
+		if (parse_task(text, &tasks[nr_tasks])) {
+			fprintf(stderr, "%s:%d: can't parse task\n", path, line);
+			exit(2);
+		}
+		tasks[nr_tasks].line = line;
+		nr_cpus = max(nr_cpus, tasks[nr_tasks].cpu + 1);
+		nr_tasks++;
+	}
+	fclose(f);
+
+	if (declared && nr_locks > declared) {
+		fprintf(stderr, "%s: uses lock %d but declares only %d\n", path,
+			nr_locks - 1, declared);
+		exit(2);
+	}
+}
+
+static u64 scale(u64 us, int usage)
+{
+	return (us * usage + 50) / 100;
+}
+
+struct entry {
+	struct analysis_task t;
+	struct task *task;
+};
+
+static int entry_cmp(const void *a, const void *b)
+{
+	return analysis_rm_cmp(&((const struct entry *) a)->t,
+			       &((const struct entry *) b)->t);
+}
+
+/*
+ * Check the tasks on one CPU at a usage point. Returns 1 if they are
+ * schedulable, or 0 and sets *line for a fixed priority miss.
+ */
+static int analyze_cpu(int cpu, int usage, int *line)
+{
+	struct entry *e = calloc(nr_tasks, sizeof(*e));
+	struct analysis_task *set = calloc(nr_tasks, sizeof(*set));
+	struct analysis_cs *cs = NULL;
+	int nr = 0, nr_cs = 0, ok, i, j, miss;
+
+	for (i = 0; i < nr_tasks; i++) {
+		if (tasks[i].cpu != cpu)
+			continue;
+		e[nr].t.period = tasks[i].period;
+		e[nr].t.deadline = tasks[i].deadline;
+		e[nr].t.exec = scale(tasks[i].usage, usage);
+		e[nr].task = &tasks[i];
+		nr++;
+	}
+	qsort(e, nr, sizeof(*e), entry_cmp);
+
+	for (i = 0; i < nr; i++) {
+		set[i] = e[i].t;
+		cs = realloc(cs, (nr_cs + e[i].task->nr_cs + 1) * sizeof(*cs));
+		for (j = 0; j < e[i].task->nr_cs; j++, nr_cs++) {
+			cs[nr_cs] = e[i].task->cs[j];
+			cs[nr_cs].task = i;
+			cs[nr_cs].length = min(scale(cs[nr_cs].length, usage),
+					       set[i].exec);
+		}
+	}
+
+	*line = 0;
+	switch (sched->base.id) {
+	case SCHED_RT_RMA:
+	case SCHED_RT_ICPP:
+		if (nr_locks && analysis_blocking(set, nr, cs, nr_cs, nr_locks,
+						   sched->base.id == SCHED_RT_RMA)) {
+			fprintf(stderr, "out of memory\n");
+			exit(2);
+		}
+		miss = analysis_fp(set, nr);
+		ok = miss < 0;
+		if (!ok)
+			*line = e[miss].task->line;
+		break;
+	case SCHED_RT_EDF:
+	case SCHED_RT_HYBRID:
+	case SCHED_RT_DASA:
+	case SCHED_RT_DASA_ND:
+	case SCHED_RT_LBESA:
+		ok = analysis_edf(set, nr, NULL);
+		break;
+	default:
+		// Refused in main
+		ok = 0;
+	}
+
+	free(e);
+	free(set);
+	free(cs);
+	return ok;
+}
+
+static void *analyze_points(void *arg)
+{
+	struct result *r;
+	int i, cpu;
+
+	while ((i = __atomic_fetch_add(&next_point, 1, __ATOMIC_RELAXED)) <
+	       nr_points) {
+		r = &results[i];
+		r->schedulable = 1;
+		r->cpu = -1;
+		for (cpu = 0; cpu < nr_cpus && r->schedulable; cpu++) {
+			if (!analyze_cpu(cpu, r->usage, &r->line)) {
+				r->schedulable = 0;
+				r->cpu = cpu;
+			}
+		}
+	}
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	int lo = 100, hi = -1, step = 1, nr_threads = 0;
+	struct timespec start, end;
+	pthread_t *threads;
+	int opt, i, failed = 0;
+
+	sched = find_local_scheduler("EDF");
+	while ((opt = getopt(argc, argv, "s:c:j:")) != -1) {
+		switch (opt) {
+		case 's':
+			sched = find_local_scheduler(optarg);
+			if (sched == NULL) {
+				fprintf(stderr, "no scheduler named %s\n", optarg);
+				return 2;
+			}
+			switch (sched->base.id) {
+			case SCHED_RT_RMA:
+			case SCHED_RT_ICPP:
+			case SCHED_RT_EDF:
+			case SCHED_RT_HYBRID:
+			case SCHED_RT_DASA:
+			case SCHED_RT_DASA_ND:
+			case SCHED_RT_LBESA:
+				break;
+			default:
+				fprintf(stderr, "no schedulability test for %s\n",
+					optarg);
+				return 2;
+			}
+			break;
+		case 'c':
+			if (sscanf(optarg, "%d:%d:%d", &lo, &hi, &step) < 1)
+				usage(argv[0]);
+			break;
+		case 'j': nr_threads = atoi(optarg); break;
+		default: usage(argv[0]);
+		}
+	}
+	if (hi < lo)
+		hi = lo;
+	if (optind != argc - 1 || lo < 0 || step < 1)
+		usage(argv[0]);
+	if (nr_threads < 1)
+		nr_threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+	read_tasks(argv[optind]);
+
+	nr_points = (hi - lo) / step + 1;
+	results = calloc(nr_points, sizeof(*results));
+	for (i = 0; i < nr_points; i++)
+		results[i].usage = lo + i * step;
+	nr_threads = min(nr_threads, nr_points);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	threads = calloc(nr_threads, sizeof(*threads));
+	for (i = 0; i < nr_threads; i++)
+		pthread_create(&threads[i], NULL, analyze_points, NULL);
+	for (i = 0; i < nr_threads; i++)
+		pthread_join(threads[i], NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	for (i = 0; i < nr_points; i++) {
+		printf("%s,%.2f,%d,%d,%d\n", sched->base.name,
+		       results[i].usage / 100.0, results[i].schedulable,
+		       results[i].cpu, results[i].line);
+		failed |= !results[i].schedulable;
+	}
+	fprintf(stderr, "%d points in %.3f ms on %d threads\n", nr_points,
+		(end.tv_sec - start.tv_sec) * 1e3 +
+		(end.tv_nsec - start.tv_nsec) / 1e6, nr_threads);
+
+	free(threads);
+	free(results);
+	free(tasks);
+	return failed;
+}
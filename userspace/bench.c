@@ -0,0 +1,832 @@
+/* userspace/bench.c
+ *
+ * Per-decision latency benchmark for the ChronOS scheduler modules.
+ *
+ * Builds a synthetic ready queue of N tasks at a single instant and calls
+ * each registered scheduler on it repeatedly, reporting wall-clock ns per
+ * decision along with the allocations, printk calls and (when the PMU is
+ * available) cache misses each decision costs.
+ *
+ * With -r, each scheduler's decisions are first checked against those of
+ * a reference scheduler on snapshots across the results*.csv load range,
+ * and those that take lock registrations (ICPP) are checked never to
+ * pick a task that would block (see check_ceilings()).
+ *
+ * With -k, it instead times the rq_snapshot.h kernels against the list
+ * walks over timespecs that they replace.
+ *
+ * With -m, it instead runs the global schedulers on 1 to that many CPUs,
+ * one thread per CPU, each completing whatever it is given and releasing
+ * that task's next job, and reports decisions per second across them.
+ * First, it checks that the jobs running on those CPUs are always the
+ * earliest deadline ones ready (see check_global()).
+ *
+ * With -j, each decision is followed by completing the job it picked and
+ * releasing that task's next one, so the time per decision includes
+ * keeping the ready queue up to date.
+ *
+ * With -b, the utility accrual schedulers get that many ns per decision
+ * (see sched_budget.h), and the share of decisions that ran out of it is
+ * reported.
+ *
+ * With -T, the schedulers' decision trace is on while they are timed,
+ * and what is left in the rings after each point is appended to the
+ * given file, in the format the debugfs files use.
+ *
+ * usage: bench [-s scheduler] [-r reference] [-l load] [-n max tasks]
+ *              [-t ms per point] [-f sched flags] [-c] [-j] [-k]
+ *              [-m max cpus] [-b budget ns] [-T trace file]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <linux/percpu.h>
+#include "chronos.h"
+#include "../rq_snapshot.h"
+#include "../sched_budget.h"
+#include "../sched_trace.h"
+
+static const int sizes[] = { 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000 };
+
+static FILE *trace_out;
+static int release_jobs;
+
+static unsigned long long rng_state = 88172645463325252ULL;
+
+static unsigned long long xorshift(void)
+{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 7;
+	rng_state ^= rng_state << 17;
+	return rng_state;
+}
+
+static double uniform(void)
+{
+	return (xorshift() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void ns_to_ts(long long ns, struct timespec *ts)
+{
+	ts->tv_sec = ns / NSEC_PER_SEC;
+	ts->tv_nsec = ns % NSEC_PER_SEC;
+}
+
+static long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long) ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/*
+ * Snapshot of n jobs at time `now`, with total utilization `load`.
+ * Periods are log-uniform between 400ms and 20s like 10t_nl, each job is
+ * somewhere in its period and has done some of its work.
+ */
+static struct rt_info *make_tasks(int n, double load, struct timespec *now,
+			      unsigned int seed)
+{
+	struct rt_info *tasks = calloc(n, sizeof(*tasks));
+	long long base = (long long) now->tv_sec * NSEC_PER_SEC + now->tv_nsec;
+	int i;
+
+	rng_state = 88172645463325252ULL + seed;
+
+	for (i = 0; i < n; i++) {
+		double period = 0.4e9 * exp2(uniform() * 5.64);
+		double usage = period * load / n * (0.5 + uniform());
+		double elapsed = uniform();
+
+		ns_to_ts((long long) period, &tasks[i].period);
+		ns_to_ts((long long) usage, &tasks[i].exec_time);
+		ns_to_ts(base + (long long) (period * (1.0 - elapsed)) + 1,
+			 &tasks[i].deadline);
+		ns_to_ts((long long) (usage * (1.0 - elapsed * uniform())) + 1,
+			 &tasks[i].left);
+		tasks[i].max_util = 1 + xorshift() % 500;
+	}
+
+	return tasks;
+}
+
+// Write out and empty every CPU's trace ring
+static void trace_drain(void)
+{
+	struct sched_trace_event events[256];
+	int cpu, nr;
+
+	if (trace_out == NULL)
+		return;
+
+	for_each_possible_cpu(cpu)
+		while ((nr = sched_trace_consume(cpu, events, ARRAY_SIZE(events))) > 0)
+			fwrite(events, sizeof(events[0]), nr, trace_out);
+}
+
+static void trace_close(void)
+{
+	if (trace_out == NULL)
+		return;
+
+	fclose(trace_out);
+	fprintf(stderr, "%llu trace records lost\n",
+		(unsigned long long) sched_trace_lost());
+}
+
+static int perf_open(void)
+{
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = PERF_COUNT_HW_CACHE_MISSES;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void bench_one(struct rt_sched_local *s, int n, double load,
+		      long long budget, int flags, int perf_fd, int csv)
+{
+	struct timespec now = { 1000, 0 };
+	struct chronos_rq rq;
+	struct rt_info *tasks, *task;
+	struct sched_stats before, after;
+	unsigned long printks, allocs;
+	long long start, elapsed;
+	long long misses = -1;
+	long iters = 0;
+	int i;
+
+	chronos_set_time(&now);
+	chronos_rq_init(&rq, s, 0, flags);
+	tasks = make_tasks(n, load, &now, 0);
+	for (i = 0; i < n; i++)
+		chronos_rq_add(&rq, &tasks[i]);
+
+	// Warm up, and let any lazily built state settle
+	chronos_rq_schedule(&rq);
+
+	printks = chronos_printk_count;
+	allocs = chronos_alloc_count;
+	if (perf_fd >= 0) {
+		ioctl(perf_fd, PERF_EVENT_IOC_RESET, 0);
+		ioctl(perf_fd, PERF_EVENT_IOC_ENABLE, 0);
+	}
+
+	sched_stats_read(chronos_cpu, &before);
+	sched_trace_enabled = trace_out != NULL;
+	start = now_ns();
+	do {
+		task = chronos_rq_schedule(&rq);
+		if (release_jobs && task != NULL) {
+			chronos_rq_remove(&rq, task);
+			add_ts(&task->deadline, &task->period, &task->deadline);
+			chronos_rq_add(&rq, task);
+		}
+		iters++;
+		elapsed = now_ns() - start;
+	} while (elapsed < budget);
+	sched_trace_enabled = 0;
+	sched_stats_read(chronos_cpu, &after);
+
+	if (perf_fd >= 0) {
+		ioctl(perf_fd, PERF_EVENT_IOC_DISABLE, 0);
+		if (read(perf_fd, &misses, sizeof(misses)) != sizeof(misses))
+			misses = -1;
+	}
+
+	printks = chronos_printk_count - printks;
+	allocs = chronos_alloc_count - allocs;
+	trace_drain();
+
+	if (csv) {
+		printf("%s,%d,%.1f,%.2f,%.2f,", s->base.name, n,
+		       (double) elapsed / iters, (double) allocs / iters,
+		       (double) printks / iters);
+		if (misses >= 0)
+			printf("%.2f", (double) misses / iters);
+		if (sched_budget_ns)
+			printf(",%.3f", (double) (after.budget_hits -
+						  before.budget_hits) / iters);
+		printf("\n");
+	} else {
+		printf("%-10s %6d %14.1f %10.2f %12.2f ", s->base.name, n,
+		       (double) elapsed / iters, (double) allocs / iters,
+		       (double) printks / iters);
+		if (misses >= 0)
+			printf("%12.2f", (double) misses / iters);
+		else
+			printf("%12s", "-");
+		if (sched_budget_ns)
+			printf(" %10.3f", (double) (after.budget_hits -
+						    before.budget_hits) / iters);
+		printf("\n");
+	}
+	fflush(stdout);
+
+	chronos_rq_clear(&rq);
+	free(tasks);
+}
+
+/*
+ * Run s and ref on the same snapshots, at every load in the results*.csv
+ * sweeps, and count the decisions they disagree on. Odd seeds round the
+ * deadlines up to whole seconds, so that many tie, and add the tasks in
+ * period order: the reference, walking a period-sorted queue, breaks
+ * deadline ties that way, and a deadline-sorted queue keeps them so.
+ */
+static int by_period(const void *a, const void *b)
+{
+	struct rt_info *x = (struct rt_info *) a, *y = (struct rt_info *) b;
+
+	return compare_ts(&x->period, &y->period);
+}
+
+static void compare(struct rt_sched_local *s, struct rt_sched_local *ref,
+		    int n, int flags)
+{
+	struct timespec now = { 1000, 0 };
+	struct chronos_rq rq;
+	struct rt_info *tasks;
+	struct rt_info *a, *b;
+	int load, seed, i;
+	int decisions = 0, mismatches = 0;
+
+	chronos_set_time(&now);
+
+	for (load = 65; load <= 155; load += 10) {
+		for (seed = 0; seed < 20; seed++) {
+			tasks = make_tasks(n, load / 100.0, &now, seed);
+			if (seed & 1) {
+				for (i = 0; i < n; i++)
+					if (tasks[i].deadline.tv_nsec) {
+						tasks[i].deadline.tv_sec++;
+						tasks[i].deadline.tv_nsec = 0;
+					}
+				qsort(tasks, n, sizeof(*tasks), by_period);
+			}
+
+			chronos_rq_init(&rq, s, 0, flags);
+			for (i = 0; i < n; i++)
+				chronos_rq_add(&rq, &tasks[i]);
+			a = chronos_rq_schedule(&rq);
+			chronos_rq_clear(&rq);
+
+			chronos_rq_init(&rq, ref, 0, flags);
+			for (i = 0; i < n; i++)
+				chronos_rq_add(&rq, &tasks[i]);
+			b = chronos_rq_schedule(&rq);
+			chronos_rq_clear(&rq);
+
+			if (a != b)
+				mismatches++;
+			decisions++;
+
+			free(tasks);
+		}
+	}
+
+	printf("%-10s %6d   %d/%d decisions differ from %s\n", s->base.name,
+	       n, mismatches, decisions, ref->base.name);
+	fflush(stdout);
+}
+
+#define CHECK_LOCKS	8
+
+/*
+ * Drive s through random releases, completions, and locks and unlocks
+ * by the task it picked, with each task's locks registered up front, and
+ * count the decisions that pick a task needing a lock another task
+ * holds. Under a ceiling protocol there should be none: the holder runs
+ * at the priority of the highest task that may want the lock. Each of
+ * the 400 rounds starts over with new tasks and locks, so that a
+ * ceiling only learned when a lock is first taken would show.
+ */
+static void check_ceilings(struct rt_sched_local *s, int n, int flags)
+{
+	struct timespec now = { 1000, 0 };
+	struct mutex_head locks[CHECK_LOCKS];
+	struct chronos_rq rq;
+	struct rt_info *tasks, *t;
+	unsigned int *uses;
+	bool *ready;
+	int rounds = 400, decisions = 50, blocked = 0;
+	int round, d, i, l;
+
+	chronos_set_time(&now);
+	tasks = calloc(n, sizeof(*tasks));
+	uses = calloc(n, sizeof(*uses));
+	ready = calloc(n, sizeof(*ready));
+	rng_state = 88172645463325252ULL;
+
+	for (round = 0; round < rounds; round++) {
+		chronos_rq_init(&rq, s, 0, flags);
+		memset(locks, 0, sizeof(locks));
+		memset(tasks, 0, n * sizeof(*tasks));
+		memset(uses, 0, n * sizeof(*uses));
+		memset(ready, 0, n * sizeof(*ready));
+
+		for (i = 0; i < n; i++) {
+			ns_to_ts(1000000 + xorshift() % 1000000000, &tasks[i].period);
+			tasks[i].max_util = 1;
+			// Up to three of the locks
+			for (l = 0; l < 3; l++)
+				uses[i] |= 1U << (xorshift() % (CHECK_LOCKS + 2));
+			uses[i] &= (1U << CHECK_LOCKS) - 1;
+			for (l = 0; l < CHECK_LOCKS; l++)
+				if (uses[i] & (1U << l))
+					chronos_rq_register_lock(&rq, &tasks[i],
+								 &locks[l]);
+		}
+
+		t = NULL;
+		for (d = 0; d < decisions; d++) {
+			i = xorshift() % n;
+			l = xorshift() % CHECK_LOCKS;
+			if (!ready[i] && (t == NULL || xorshift() % 2)) {
+				ns_to_ts(1000 * NSEC_PER_SEC + xorshift() % NSEC_PER_SEC,
+					 &tasks[i].deadline);
+				ready[i] = true;
+				chronos_rq_add(&rq, &tasks[i]);
+			} else if (t != NULL && t->locks_held) {
+				for (l = 0; locks[l].owner_t != t; l++)
+					;
+				chronos_rq_unlock(&rq, t, &locks[l]);
+			} else if (t != NULL && (uses[t - tasks] & (1U << l)) &&
+				   locks[l].owner_t == NULL) {
+				chronos_rq_lock(&rq, t, &locks[l]);
+			} else if (t != NULL) {
+				ready[t - tasks] = false;
+				chronos_rq_complete(&rq, t);
+			}
+
+			t = chronos_rq_schedule(&rq);
+			for (l = 0; t != NULL && l < CHECK_LOCKS; l++)
+				if ((uses[t - tasks] & (1U << l)) &&
+				    locks[l].owner_t != NULL && locks[l].owner_t != t) {
+					blocked++;
+					break;
+				}
+		}
+
+		chronos_rq_clear(&rq);
+	}
+
+	printf("%-10s %6d   %d/%d decisions pick a task that would block\n",
+	       s->base.name, n, blocked, rounds * decisions);
+	fflush(stdout);
+
+	free(ready);
+	free(uses);
+	free(tasks);
+}
+
+/*
+ * The operations the modules used to do by walking the ready list, and
+ * the same operations on a snapshot.
+ */
+static struct rt_info *list_earliest(struct list_head *head)
+{
+	struct rt_info *it, *best = NULL;
+
+	list_for_each_entry(it, head, task_list[LOCAL_LIST])
+		if (best == NULL || earlier_deadline(&it->deadline, &best->deadline))
+			best = it;
+	return best;
+}
+
+static struct rt_info *list_first_infeasible(struct list_head *head)
+{
+	struct timespec finish = CURRENT_TIME;
+	struct rt_info *it;
+
+	list_for_each_entry(it, head, task_list[LOCAL_LIST]) {
+		add_ts(&finish, &it->left, &finish);
+		if (earlier_deadline(&it->deadline, &finish))
+			return it;
+	}
+	return NULL;
+}
+
+static struct rt_info *list_most_unworthy(struct list_head *head)
+{
+	struct rt_info *it, *best = NULL;
+
+	list_for_each_entry(it, head, task_list[LOCAL_LIST])
+		if (best == NULL || it->local_ivd >= best->local_ivd)
+			best = it;
+	return best;
+}
+
+static void snapshot_take(struct rq_snapshot *snap, struct list_head *head)
+{
+	struct rt_info *it;
+
+	rq_snapshot_reset(snap);
+	list_for_each_entry(it, head, task_list[LOCAL_LIST])
+		rq_snapshot_add(snap, it);
+}
+
+enum { K_LIST_ARGMIN, K_LIST_PREFIX, K_LIST_ARGMAX, K_TAKE,
+       K_ARGMIN, K_PREFIX, K_ARGMAX, NR_KERNELS };
+
+static const char *kernel_names[NR_KERNELS] = {
+	"walk-min", "walk-sum", "walk-max", "snapshot", "argmin", "prefix",
+	"argmax"
+};
+
+static volatile long kernel_sink;
+
+static void run_kernel(int k, struct list_head *head, struct rq_snapshot *snap,
+		       s64 now)
+{
+	switch (k) {
+	case K_LIST_ARGMIN: kernel_sink = (long) list_earliest(head); break;
+	case K_LIST_PREFIX: kernel_sink = (long) list_first_infeasible(head); break;
+	case K_LIST_ARGMAX: kernel_sink = (long) list_most_unworthy(head); break;
+	case K_TAKE: snapshot_take(snap, head); break;
+	case K_ARGMIN: kernel_sink = snapshot_argmin_deadline(snap); break;
+	case K_PREFIX: kernel_sink = snapshot_first_infeasible(snap, now); break;
+	case K_ARGMAX: kernel_sink = snapshot_argmax_ivd(snap); break;
+	}
+}
+
+/*
+ * ns per call of each kernel on an n task ready queue. The queue is kept
+ * in deadline order, like the one the modules see, and its tasks are
+ * allocated one by one so the list walks pay for scattered rt_infos.
+ */
+static void bench_kernels(int n, double load, long long budget, int csv)
+{
+	struct timespec now = { 1000, 0 };
+	struct rq_snapshot snap = { 0 };
+	struct chronos_rq rq;
+	struct rt_info *tasks, **scattered;
+	double ns[NR_KERNELS];
+	long long start, elapsed;
+	long iters;
+	int i, k;
+
+	chronos_set_time(&now);
+	chronos_rq_init(&rq, find_local_scheduler("EDF"), 0, 0);
+	tasks = make_tasks(n, load, &now, 0);
+	scattered = calloc(n, sizeof(*scattered));
+	for (i = 0; i < n; i++) {
+		scattered[i] = malloc(sizeof(**scattered) + 64 * (xorshift() % 8));
+		*scattered[i] = tasks[i];
+		scattered[i]->local_ivd = scattered[i]->max_util;
+		chronos_rq_add(&rq, scattered[i]);
+	}
+	snapshot_take(&snap, &rq.head.task_list[LOCAL_LIST]);
+
+	for (k = 0; k < NR_KERNELS; k++) {
+		iters = 0;
+		start = now_ns();
+		do {
+			run_kernel(k, &rq.head.task_list[LOCAL_LIST], &snap,
+				   timespec_to_ns(&now));
+			iters++;
+			elapsed = now_ns() - start;
+		} while (elapsed < budget / NR_KERNELS);
+		ns[k] = (double) elapsed / iters;
+	}
+
+	printf(csv ? "%d" : "%6d", n);
+	for (k = 0; k < NR_KERNELS; k++)
+		printf(csv ? ",%.1f" : " %9.1f", ns[k]);
+	printf("\n");
+	fflush(stdout);
+
+	chronos_rq_clear(&rq);
+	for (i = 0; i < n; i++)
+		free(scattered[i]);
+	free(scattered);
+	free(tasks);
+	rq_snapshot_free(&snap);
+}
+
+struct global_cpu {
+	pthread_t thread;
+	struct chronos_grq *grq;
+	pthread_barrier_t *start;
+	struct rt_info *tasks;
+	int cpu, stride, nr_tasks;
+	long long budget;
+	long decisions, migrations;
+};
+
+static void *global_cpu_run(void *arg)
+{
+	struct global_cpu *c = arg;
+	struct rt_info *t;
+	long long start;
+	int i;
+
+	for (i = c->cpu; i < c->nr_tasks; i += c->stride)
+		chronos_grq_add(c->grq, &c->tasks[i], c->cpu);
+
+	pthread_barrier_wait(c->start);
+
+	start = now_ns();
+	do {
+		for (i = 0; i < 64; i++) {
+			t = chronos_grq_schedule(c->grq, c->cpu);
+			c->decisions++;
+			if (t == NULL)
+				continue;
+			if ((t - c->tasks) % c->stride != c->cpu)
+				c->migrations++;
+
+			// The job completes and the next one is released here
+			chronos_grq_remove(c->grq, t, c->cpu);
+			add_ts(&t->deadline, &t->period, &t->deadline);
+			chronos_grq_add(c->grq, t, c->cpu);
+		}
+	} while (now_ns() - start < c->budget);
+
+	return NULL;
+}
+
+/*
+ * Play nr_cpus CPUs from one thread through random releases and
+ * completions, rescheduling a CPU only when its job completes or the
+ * scheduler tells it to, and count the events after which a ready job
+ * waits while some CPU is idle or runs a later deadline. Every job has
+ * 1us to do and a deadline at least 1s off, so nothing is shed and
+ * G-DASA should keep the earliest deadlines running as G-EDF does.
+ */
+static void check_global(struct rt_sched_global *s, int nr_cpus, int flags)
+{
+	struct timespec now = { 1000, 0 };
+	struct rt_info *running[NR_CPUS] = { NULL };
+	struct rt_info *tasks;
+	struct chronos_grq grq;
+	s64 latest, earliest, d;
+	bool *ready, again;
+	int n = 4 * nr_cpus, events = 20000, waiting = 0;
+	int e, i, cpu, busy;
+
+	chronos_set_time(&now);
+	chronos_grq_init(&grq, s, nr_cpus, flags);
+	tasks = calloc(n, sizeof(*tasks));
+	ready = calloc(n, sizeof(*ready));
+	rng_state = 88172645463325252ULL;
+
+	for (i = 0; i < n; i++) {
+		ns_to_ts(NSEC_PER_SEC, &tasks[i].period);
+		ns_to_ts(1000, &tasks[i].exec_time);
+		tasks[i].max_util = 1 + xorshift() % 500;
+	}
+
+	for (e = 0; e < events; e++) {
+		i = xorshift() % n;
+		for (busy = 0; busy < nr_cpus && running[busy] != &tasks[i]; busy++)
+			;
+
+		if (!ready[i]) {
+			ns_to_ts(1001 * NSEC_PER_SEC + xorshift() % NSEC_PER_SEC,
+				 &tasks[i].deadline);
+			tasks[i].left = tasks[i].exec_time;
+			ready[i] = true;
+			chronos_grq_add(&grq, &tasks[i], xorshift() % nr_cpus);
+		} else if (busy < nr_cpus) {
+			// It completes, and its CPU picks what runs next
+			chronos_grq_remove(&grq, &tasks[i], busy);
+			ready[i] = false;
+			running[busy] = NULL;
+			resched_cpu(busy);
+		}
+
+		do {
+			again = false;
+			for (cpu = 0; cpu < nr_cpus; cpu++) {
+				if (!chronos_grq_need_resched(&grq, cpu))
+					continue;
+				running[cpu] = chronos_grq_schedule(&grq, cpu);
+				again = true;
+			}
+		} while (again);
+
+		latest = 0;
+		for (cpu = 0; cpu < nr_cpus; cpu++)
+			latest = max(latest, running[cpu] ?
+				     timespec_to_ns(&running[cpu]->deadline) : S64_MAX);
+		earliest = S64_MAX;
+		for (i = 0; i < n; i++) {
+			for (busy = 0; busy < nr_cpus && running[busy] != &tasks[i]; busy++)
+				;
+			d = timespec_to_ns(&tasks[i].deadline);
+			if (ready[i] && busy == nr_cpus && d < earliest)
+				earliest = d;
+		}
+		if (earliest < latest)
+			waiting++;
+	}
+
+	for (i = 0; i < n; i++)
+		if (ready[i])
+			chronos_grq_remove(&grq, &tasks[i], tasks[i].cpu);
+
+	printf("%-10s %4d   %d/%d events leave an earlier job waiting\n",
+	       s->base.name, nr_cpus, waiting, events);
+	fflush(stdout);
+
+	free(ready);
+	free(tasks);
+}
+
+static void bench_global(struct rt_sched_global *s, int nr_cpus, int n,
+			 double load, long long budget, int flags, int csv)
+{
+	struct timespec now = { 1000, 0 };
+	struct global_cpu cpus[NR_CPUS];
+	struct chronos_grq grq;
+	pthread_barrier_t start;
+	struct rt_info *tasks, *t;
+	long decisions = 0, migrations = 0;
+	int cpu;
+
+	chronos_set_time(&now);
+	chronos_grq_init(&grq, s, nr_cpus, flags);
+	tasks = make_tasks(n, load * nr_cpus, &now, 0);
+	pthread_barrier_init(&start, NULL, nr_cpus);
+
+	sched_trace_enabled = trace_out != NULL;
+	for (cpu = 0; cpu < nr_cpus; cpu++) {
+		cpus[cpu] = (struct global_cpu) {
+			.grq = &grq, .start = &start, .tasks = tasks,
+			.cpu = cpu, .stride = nr_cpus, .nr_tasks = n,
+			.budget = budget,
+		};
+		pthread_create(&cpus[cpu].thread, NULL, global_cpu_run, &cpus[cpu]);
+	}
+	for (cpu = 0; cpu < nr_cpus; cpu++) {
+		pthread_join(cpus[cpu].thread, NULL);
+		decisions += cpus[cpu].decisions;
+		migrations += cpus[cpu].migrations;
+	}
+	sched_trace_enabled = 0;
+	trace_drain();
+
+	// Empty the queues; each CPU ends up with what the others left it
+	for (cpu = 0; cpu < nr_cpus; cpu++)
+		while ((t = chronos_grq_schedule(&grq, cpu)) != NULL)
+			chronos_grq_remove(&grq, t, cpu);
+
+	printf(csv ? "%s,%d,%d,%.0f,%.3f\n" : "%-10s %4d %6d %14.0f %10.3f\n",
+	       s->base.name, nr_cpus, n, decisions / (budget / 1e9),
+	       (double) migrations / decisions);
+	fflush(stdout);
+
+	pthread_barrier_destroy(&start);
+	free(tasks);
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-s scheduler] [-r reference] [-l load] "
+		"[-n max tasks] [-t ms per point] [-f sched flags] [-c] [-j]\n"
+		"\t[-k] [-m max cpus] [-b budget ns] [-T trace file]\n", prog);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	struct rt_sched_local *s, *ref = NULL;
+	struct rt_sched_global *g;
+	const char *only = NULL;
+	double load = 1.0;
+	long long budget = 200 * 1000000LL;
+	int max_tasks = 10000;
+	int flags = 0, csv = 0, kernels = 0, max_cpus = 0;
+	int perf_fd, opt, k;
+	unsigned int i;
+
+	while ((opt = getopt(argc, argv, "s:r:l:n:t:f:cjkm:b:T:")) != -1) {
+		switch (opt) {
+		case 's': only = optarg; break;
+		case 'r':
+			ref = find_local_scheduler(optarg);
+			if (ref == NULL) {
+				fprintf(stderr, "no scheduler named %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'l': load = atof(optarg); break;
+		case 'n': max_tasks = atoi(optarg); break;
+		case 't': budget = atoll(optarg) * 1000000LL; break;
+		case 'f': flags = strtol(optarg, NULL, 0); break;
+		case 'c': csv = 1; break;
+		case 'j': release_jobs = 1; break;
+		case 'k': kernels = 1; break;
+		case 'm': max_cpus = min(atoi(optarg), NR_CPUS); break;
+		case 'b': sched_budget_ns = strtoull(optarg, NULL, 0); break;
+		case 'T':
+			trace_out = fopen(optarg, "wb");
+			if (trace_out == NULL) {
+				perror(optarg);
+				return 1;
+			}
+			break;
+		default: usage(argv[0]);
+		}
+	}
+
+	if (kernels) {
+		printf(csv ? "tasks" : "%6s", "tasks");
+		for (k = 0; k < NR_KERNELS; k++)
+			printf(csv ? ",%s" : " %9s", kernel_names[k]);
+		printf("\n");
+		for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+			if (sizes[i] > max_tasks)
+				break;
+			bench_kernels(sizes[i], load, budget, csv);
+		}
+		return 0;
+	}
+
+	if (max_cpus) {
+		list_for_each_entry(g, &chronos_global_schedulers, base.list) {
+			if (only && strcmp(only, g->base.name) != 0)
+				continue;
+			for (k = 1; k <= max_cpus; k *= 2)
+				check_global(g, k, flags);
+		}
+		printf("\n");
+
+		if (csv)
+			printf("scheduler,cpus,tasks,decisions_per_sec,"
+			       "migrations_per_decision\n");
+		else
+			printf("%-10s %4s %6s %14s %10s\n", "scheduler", "cpus",
+			       "tasks", "decisions/s", "migrated");
+		list_for_each_entry(g, &chronos_global_schedulers, base.list) {
+			if (only && strcmp(only, g->base.name) != 0)
+				continue;
+			for (k = 1; k <= max_cpus; k *= 2)
+				bench_global(g, k, max_tasks, load, budget, flags, csv);
+		}
+		trace_close();
+		return 0;
+	}
+
+	if (only && !find_local_scheduler(only)) {
+		fprintf(stderr, "no scheduler named %s\n", only);
+		return 1;
+	}
+
+	if (ref) {
+		list_for_each_entry(s, &chronos_local_schedulers, base.list) {
+			if (s == ref || (only && strcmp(only, s->base.name) != 0))
+				continue;
+			for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+				if (sizes[i] > max_tasks)
+					break;
+				compare(s, ref, sizes[i], flags);
+			}
+			if (s->register_lock)
+				check_ceilings(s, min(max_tasks, 20), flags);
+		}
+		printf("\n");
+	}
+
+	perf_fd = perf_open();
+
+	if (csv)
+		printf("scheduler,tasks,ns_per_decision,allocs_per_decision,"
+		       "printk_per_decision,cache_misses_per_decision%s\n",
+		       sched_budget_ns ? ",budget_hits_per_decision" : "");
+	else
+		printf("%-10s %6s %14s %10s %12s %12s%s\n", "scheduler", "tasks",
+		       "ns/decision", "allocs", "printk", "cache-miss",
+		       sched_budget_ns ? " budget-hit" : "");
+
+	list_for_each_entry(s, &chronos_local_schedulers, base.list) {
+		if (only && strcmp(only, s->base.name) != 0)
+			continue;
+		for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+			if (sizes[i] > max_tasks)
+				break;
+			bench_one(s, sizes[i], load, budget, flags, perf_fd, csv);
+		}
+	}
+
+	if (perf_fd >= 0)
+		close(perf_fd);
+	trace_close();
+	return 0;
+}
@@ -0,0 +1,82 @@
+# userspace/check_analyze.sh
+#
+# Checks analyze against task sets with constrained deadlines whose
+# answers are worked out by hand, and against the implicit deadline
+# task files in the repo. Prints each mismatch and exits 1 if there are
+# any.
+#
+# usage: check_analyze.sh
+
+dir=`dirname $0`
+set=`mktemp`
+trap 'rm -f $set' EXIT
+failed=0
+
+# check scheduler expected-line tasks...; each task is "period usage deadline"
+check()
+{
+	sched=$1
+	expected=$2
+	shift 2
+	echo "L	0" > $set
+	for t in "$@"; do
+		echo "$t" | awk '{ printf "T\t0\t1\t0\t%s\t%s\t1\t0\t%s\n", $1, $2, $3 }'
+	done >> $set
+	got=`$dir/analyze -s $sched $set 2>/dev/null`
+	if [ "$got" != "$expected" ]; then
+		echo "$sched $*: expected $expected, got $got"
+		failed=1
+	fi
+}
+
+# Utilization 0.4, but both jobs are due at 3 with 4 to do
+check EDF "EDF,1.00,0,0,0" "10 2 3" "10 2 3"
+# Demand at 2, 3, 7 and 12 is 1, 2, 4 and 5
+check EDF "EDF,1.00,1,-1,0" "5 1 2" "5 1 3" "10 2 7"
+# Full utilization: demand at 4k and 4k + 1 is exactly the interval
+check EDF "EDF,1.00,1,-1,0" "2 1 1" "4 2 4"
+check LBESA "LBESA,1.00,1,-1,0" "2 1 1" "4 2 4"
+# The same at 3 is 4
+check EDF "EDF,1.00,0,0,0" "2 1 1" "4 2 3"
+# Full utilization, with a hyperperiod of about 2e12 us to check up to.
+# One short of its period, the second task's deadline is never missed;
+# two short, demand first exceeds the interval at 666667 of its periods.
+check EDF "EDF,1.00,1,-1,0" "2000000 1000000 2000000" "2000006 1000003 2000005"
+check EDF "EDF,1.00,0,0,0" "2000000 1000000 2000000" "2000006 1000003 2000004"
+# Rate monotonic runs the period 5 task first, so the other answers at
+# 4, after its deadline; deadline monotonic order would have made it
+check RMA "RMA,1.00,0,0,2" "10 2 3" "5 2 5"
+check ICPP "ICPP,1.00,0,0,2" "10 2 3" "5 2 5"
+check EDF "EDF,1.00,1,-1,0" "10 2 3" "5 2 5"
+check RMA "RMA,1.00,1,-1,0" "10 2 10" "5 2 3"
+
+# A deadline past the period is refused
+echo "L	0
+T	0	1	0	10	2	1	0	11" > $set
+if $dir/analyze $set > /dev/null 2>&1 || [ $? -ne 2 ]; then
+	echo "deadline past the period: not refused"
+	failed=1
+fi
+
+# The implicit deadline task files: 5t_nl is exactly full at 100
+for f in 5t_nl:100 10t_nl:95; do
+	for sched in EDF LBESA RMA; do
+		$dir/analyze -s $sched -c ${f#*:} $dir/../${f%:*} > /dev/null 2>&1
+		echo "$f $sched $?"
+	done
+done > $set
+expected="5t_nl:100 EDF 0
+5t_nl:100 LBESA 0
+5t_nl:100 RMA 1
+10t_nl:95 EDF 0
+10t_nl:95 LBESA 0
+10t_nl:95 RMA 1"
+if [ "`cat $set`" != "$expected" ]; then
+	echo "task files: expected"
+	echo "$expected"
+	echo "got"
+	cat $set
+	failed=1
+fi
+
+exit $failed
@@ -0,0 +1,40 @@
+# userspace/check_sim.sh
+#
+# Compares sim's rows with the test box's in results*.csv, with every
+# job's usage stretched by the given percent (see sim -e), and prints
+# how many rows of each scheduler differ. RMA is expected to match
+# results.csv exactly and results2.csv at all but 3 points; the exit
+# status is 1 if it doesn't. The other schedulers only come out close,
+# and are printed for reference. results3.csv came from a task set that
+# isn't in the repo, so it isn't checked.
+#
+# usage: check_sim.sh [percent]
+
+dir=`dirname $0`
+stretch=${1:-5}
+ours=`mktemp`
+theirs=`mktemp`
+trap 'rm -f $ours $theirs' EXIT
+failed=0
+
+# check results file, task file, seconds, RMA rows allowed to differ
+check()
+{
+	for sched in `cut -d, -f1 $dir/../$1 | sort -u`; do
+		grep "^$sched," $dir/../$1 > $theirs
+		$dir/sim -e $stretch -s $sched -r $3 -c 65:245:10 $dir/../$2 \
+			2> /dev/null > $ours
+		differ=`diff $ours $theirs | grep -c '^<'`
+		echo "$1 $sched: $differ/`wc -l < $theirs` rows differ"
+		if [ $sched = RMA ] && [ $differ -gt $4 ]; then
+			diff $ours $theirs
+			failed=1
+		fi
+	done
+}
+
+check results.csv 5t_nl 15 0
+check results2.csv 10t_nl 60 3
+check results4.csv 5t_nl 15 0
+
+exit $failed
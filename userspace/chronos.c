@@ -0,0 +1,523 @@
+/* userspace/chronos.c
+ *
+ * Userspace stand-ins for the ChronOS core functions that the scheduler
+ * modules call. Time is simulated: CURRENT_TIME is whatever the harness
+ * last passed to chronos_set_time(), or, in a thread that runs a
+ * simulation of its own, to chronos_set_thread_time().
+ */
+
+#include <string.h>
+#include <linux/list_sort.h>
+#include "chronos.h"
+#include "../sched_overhead.h"
+#include "../sched_stats.h"
+
+LIST_HEAD(chronos_local_schedulers);
+LIST_HEAD(chronos_global_schedulers);
+
+unsigned long chronos_printk_count;
+unsigned long chronos_alloc_count;
+unsigned long chronos_abort_count;
+
+__thread int chronos_cpu;
+int chronos_online_cpus = 1;
+
+// Set by resched_cpu(), cleared by chronos_grq_need_resched()
+static int resched_pending[NR_CPUS];
+
+static struct timespec chronos_now;
+static __thread struct timespec thread_now;
+static __thread bool thread_clock;
+
+void chronos_set_time(const struct timespec *now)
+{
+	chronos_now = *now;
+}
+
+void chronos_set_thread_time(const struct timespec *now)
+{
+	thread_now = *now;
+	thread_clock = true;
+}
+
+struct timespec current_kernel_time(void)
+{
+	return thread_clock ? thread_now : chronos_now;
+}
+
+int check_task_aborted(struct rt_info *task)
+{
+	return task_check_flag(task, ABORTED);
+}
+
+void abort_thread(struct rt_info *task)
+{
+	if (!task_check_flag(task, ABORTED))
+		__atomic_fetch_add(&chronos_abort_count, 1, __ATOMIC_RELAXED);
+	task_set_flag(task, ABORTED);
+}
+
+// The harness keeps left up to date itself
+void update_left(struct rt_info *task)
+{
+}
+
+int check_task_failure(struct rt_info *task, unsigned int flags)
+{
+	struct timespec now = current_kernel_time();
+
+	if (check_task_aborted(task))
+		return 1;
+
+	if ((flags & SCHED_FLAG_HUA) && earlier_deadline(&task->deadline, &now)) {
+		abort_thread(task);
+		return 1;
+	}
+
+	return 0;
+}
+
+long livd(struct rt_info *r, bool dep_inherit, int flags)
+{
+	struct rt_info *it;
+	long left, util;
+
+	// Deadlocked tasks are aborted to break the cycle
+	if (task_check_flag(r, DEADLOCKED)) {
+		abort_thread(r);
+		r->local_ivd = LONG_MAX;
+		return r->local_ivd;
+	}
+
+	left = timespec_to_long(&r->left);
+	util = r->max_util;
+
+	if (dep_inherit) {
+		for (it = r->dep; it != NULL && it != r; it = it->dep) {
+			left += timespec_to_long(&it->left);
+			util += it->max_util;
+		}
+	}
+
+	r->local_ivd = util ? left / util : LONG_MAX;
+	return r->local_ivd;
+}
+
+void initialize_lists(struct rt_info *task)
+{
+	int i;
+
+	for (i = SCHED_LIST1; i < SCHED_LISTS; i++)
+		INIT_LIST_HEAD(&task->task_list[i]);
+}
+
+static int compare_key(struct rt_info *a, struct rt_info *b, int sort_key)
+{
+	switch (sort_key) {
+	case SORT_KEY_DEADLINE:
+		return compare_ts(&a->deadline, &b->deadline);
+	case SORT_KEY_TDEADLINE:
+		return compare_ts(&a->temp_deadline, &b->temp_deadline);
+	case SORT_KEY_PERIOD:
+		return compare_ts(&a->period, &b->period);
+	case SORT_KEY_LVD:
+		return (a->local_ivd > b->local_ivd) - (a->local_ivd < b->local_ivd);
+	case SORT_KEY_GVD:
+		return (a->global_ivd > b->global_ivd) - (a->global_ivd < b->global_ivd);
+	}
+	return 1;
+}
+
+// Insert task into list in ascending key order. With before set, the task
+// goes ahead of any entries with an equal key. SORT_KEY_NONE appends.
+void insert_on_list(struct rt_info *task, struct rt_info *list,
+		    int list_num, int sort_key, int before)
+{
+	struct list_head *head = &list->task_list[list_num];
+	struct rt_info *it;
+	int cmp;
+
+	if (sort_key == SORT_KEY_NONE) {
+		list_add_tail(&task->task_list[list_num], head);
+		return;
+	}
+
+	list_for_each_entry(it, head, task_list[list_num]) {
+		cmp = compare_key(task, it, sort_key);
+		if (cmp < 0 || (before && cmp == 0))
+			break;
+	}
+
+	list_add_tail(&task->task_list[list_num], &it->task_list[list_num]);
+}
+
+void list_remove(struct rt_info *task, int list_num)
+{
+	list_del_init(&task->task_list[list_num]);
+}
+
+static int on_list(struct rt_info *task, struct list_head *head)
+{
+	struct rt_info *it;
+
+	list_for_each_entry(it, head, task_list[LOCAL_LIST])
+		if (it == task)
+			return 1;
+	return 0;
+}
+
+// Follow the chain of lock owners from best, as long as the owners are
+// ready on this runqueue.
+struct rt_info *get_pi_task(struct rt_info *best, struct list_head *head,
+			    int flags)
+{
+	struct rt_info *it = best, *owner;
+
+	while (it->requested_resource != NULL) {
+		owner = it->requested_resource->owner_t;
+		if (owner == NULL || owner == best || !on_list(owner, head))
+			break;
+		it = owner;
+	}
+
+	return it;
+}
+
+int add_local_scheduler(struct rt_sched_local *sched)
+{
+	list_add_tail(&sched->base.list, &chronos_local_schedulers);
+	return 0;
+}
+
+void remove_local_scheduler(struct rt_sched_local *sched)
+{
+	list_del_init(&sched->base.list);
+}
+
+struct rt_sched_local *find_local_scheduler(const char *name)
+{
+	struct rt_sched_local *s;
+
+	list_for_each_entry(s, &chronos_local_schedulers, base.list)
+		if (strcmp(s->base.name, name) == 0)
+			return s;
+	return NULL;
+}
+
+int add_global_scheduler(struct rt_sched_global *sched)
+{
+	list_add_tail(&sched->base.list, &chronos_global_schedulers);
+	return 0;
+}
+
+void remove_global_scheduler(struct rt_sched_global *sched)
+{
+	list_del_init(&sched->base.list);
+}
+
+struct rt_sched_global *find_global_scheduler(const char *name)
+{
+	struct rt_sched_global *s;
+
+	list_for_each_entry(s, &chronos_global_schedulers, base.list)
+		if (strcmp(s->base.name, name) == 0)
+			return s;
+	return NULL;
+}
+
+void chronos_rq_init(struct chronos_rq *rq, struct rt_sched_local *sched,
+		     int cpu, int flags)
+{
+	memset(rq, 0, sizeof(*rq));
+	INIT_LIST_HEAD(&rq->head.task_list[LOCAL_LIST]);
+	initialize_lists(&rq->head);
+	rq->sched = sched;
+	rq->cpu = cpu;
+	rq->flags = flags;
+
+	// Some schedulers seed their scan with local_task(head); make sure
+	// the head never looks like the best candidate.
+	rq->head.deadline.tv_sec = LONG_MAX;
+	rq->head.period.tv_sec = LONG_MAX;
+	rq->head.local_ivd = LONG_MAX;
+}
+
+// A job is released onto this CPU
+void chronos_rq_add(struct chronos_rq *rq, struct rt_info *task)
+{
+	INIT_LIST_HEAD(&task->task_list[LOCAL_LIST]);
+	initialize_lists(task);
+	task->cpu = rq->cpu;
+	task_clear_flag(task, IVD_CACHED);
+	insert_on_list(task, &rq->head, LOCAL_LIST, rq->sched->base.sort_key, 0);
+
+	chronos_cpu = rq->cpu;
+	sched_stats_release(task);
+	if (rq->sched->enqueue)
+		rq->sched->enqueue(task, rq->flags);
+}
+
+static int batch_cmp(void *priv, struct list_head *a, struct list_head *b)
+{
+	return compare_key(list_entry(a, struct rt_info, task_list[LOCAL_LIST]),
+			   list_entry(b, struct rt_info, task_list[LOCAL_LIST]),
+			   *(int *) priv);
+}
+
+/*
+ * nr jobs are released onto this CPU together. They are sorted among
+ * themselves and merged into the ready queue in one pass, landing where
+ * chronos_rq_add() one at a time, in the order given, would have put
+ * them.
+ */
+void chronos_rq_add_batch(struct chronos_rq *rq, struct rt_info **tasks, int nr)
+{
+	struct list_head *head = chronos_rq_head(rq), *pos = head;
+	struct list_head batch;
+	struct rt_info *task;
+	int sort_key = rq->sched->base.sort_key, i;
+
+	INIT_LIST_HEAD(&batch);
+	for (i = 0; i < nr; i++) {
+		initialize_lists(tasks[i]);
+		tasks[i]->cpu = rq->cpu;
+		task_clear_flag(tasks[i], IVD_CACHED);
+		list_add_tail(&tasks[i]->task_list[LOCAL_LIST], &batch);
+	}
+
+	// SORT_KEY_NONE appends them all
+	if (sort_key != SORT_KEY_NONE) {
+		list_sort(&sort_key, &batch, batch_cmp);
+		pos = head->next;
+	}
+
+	while (!list_empty(&batch)) {
+		task = local_task(batch.next);
+		while (pos != head &&
+		       compare_key(task, local_task(pos), sort_key) >= 0)
+			pos = pos->next;
+		list_move_tail(&task->task_list[LOCAL_LIST], pos);
+	}
+
+	chronos_cpu = rq->cpu;
+	for (i = 0; i < nr; i++)
+		sched_stats_release(tasks[i]);
+	if (rq->sched->enqueue_batch)
+		rq->sched->enqueue_batch(tasks, nr, rq->flags);
+	else if (rq->sched->enqueue)
+		for (i = 0; i < nr; i++)
+			rq->sched->enqueue(tasks[i], rq->flags);
+}
+
+// A job aborts or blocks
+void chronos_rq_remove(struct chronos_rq *rq, struct rt_info *task)
+{
+	chronos_cpu = rq->cpu;
+	sched_stats_leave(task);
+	if (rq->sched->dequeue)
+		rq->sched->dequeue(task, rq->flags);
+
+	list_del_init(&task->task_list[LOCAL_LIST]);
+}
+
+// A job finishes at the current time, meeting its deadline or not
+void chronos_rq_complete(struct chronos_rq *rq, struct rt_info *task)
+{
+	struct timespec now = current_kernel_time();
+
+	chronos_cpu = rq->cpu;
+	sched_stats_complete(task, !earlier_deadline(&task->deadline, &now));
+	chronos_rq_remove(rq, task);
+}
+
+void chronos_rq_clear(struct chronos_rq *rq)
+{
+	struct list_head *head = chronos_rq_head(rq);
+
+	while (!list_empty(head))
+		chronos_rq_remove(rq, local_task(head->next));
+}
+
+// task will take m at some point; call before it first runs
+void chronos_rq_register_lock(struct chronos_rq *rq, struct rt_info *task,
+			      struct mutex_head *m)
+{
+	chronos_cpu = rq->cpu;
+	if (rq->sched->register_lock)
+		rq->sched->register_lock(task, m, rq->flags);
+}
+
+// task takes m, which must be free
+void chronos_rq_lock(struct chronos_rq *rq, struct rt_info *task,
+		     struct mutex_head *m)
+{
+	m->owner_t = task;
+	task->locks_held++;
+	if (task->requested_resource == m)
+		task->requested_resource = NULL;
+
+	chronos_cpu = rq->cpu;
+	if (rq->sched->lock)
+		rq->sched->lock(task, m, rq->flags);
+}
+
+// task gives up m
+void chronos_rq_unlock(struct chronos_rq *rq, struct rt_info *task,
+		       struct mutex_head *m)
+{
+	m->owner_t = NULL;
+	task->locks_held--;
+
+	chronos_cpu = rq->cpu;
+	if (rq->sched->unlock)
+		rq->sched->unlock(task, m, rq->flags);
+}
+
+// task finds m taken and waits for it
+void chronos_rq_block(struct chronos_rq *rq, struct rt_info *task,
+		      struct mutex_head *m)
+{
+	task->requested_resource = m;
+
+	chronos_cpu = rq->cpu;
+	if (rq->sched->block)
+		rq->sched->block(task, m, rq->flags);
+}
+
+struct rt_info *chronos_rq_schedule(struct chronos_rq *rq)
+{
+	chronos_cpu = rq->cpu;
+	return rq->sched->schedule(chronos_rq_head(rq), rq->flags);
+}
+
+// Switching to task, which the last decision picked, took ns
+void chronos_rq_switch(struct chronos_rq *rq, struct rt_info *task, u64 ns)
+{
+	chronos_cpu = rq->cpu;
+	sched_overhead_switch(ns);
+}
+
+void chronos_grq_init(struct chronos_grq *grq, struct rt_sched_global *sched,
+		      int nr_cpus, int flags)
+{
+	grq->sched = sched;
+	grq->nr_cpus = nr_cpus;
+	grq->flags = flags;
+	chronos_online_cpus = nr_cpus;
+	memset(resched_pending, 0, sizeof(resched_pending));
+}
+
+void resched_cpu(int cpu)
+{
+	__atomic_store_n(&resched_pending[cpu], 1, __ATOMIC_RELEASE);
+}
+
+// Whether cpu was told to reschedule since it was last asked
+bool chronos_grq_need_resched(struct chronos_grq *grq, int cpu)
+{
+	return __atomic_exchange_n(&resched_pending[cpu], 0, __ATOMIC_ACQUIRE);
+}
+
+// A job is released on cpu; call from the thread playing that CPU
+void chronos_grq_add(struct chronos_grq *grq, struct rt_info *task, int cpu)
+{
+	initialize_lists(task);
+	task_clear_flag(task, IVD_CACHED);
+	task->cpu = cpu;
+
+	chronos_cpu = cpu;
+	sched_stats_release(task);
+	grq->sched->enqueue(task, grq->flags);
+}
+
+// A job aborts or blocks on the CPU that ran it
+void chronos_grq_remove(struct chronos_grq *grq, struct rt_info *task, int cpu)
+{
+	chronos_cpu = cpu;
+	sched_stats_leave(task);
+	grq->sched->dequeue(task, grq->flags);
+}
+
+// A job finishes at the current time on the CPU that ran it
+void chronos_grq_complete(struct chronos_grq *grq, struct rt_info *task,
+			  int cpu)
+{
+	struct timespec now = current_kernel_time();
+
+	chronos_cpu = cpu;
+	sched_stats_complete(task, !earlier_deadline(&task->deadline, &now));
+	chronos_grq_remove(grq, task, cpu);
+}
+
+struct rt_info *chronos_grq_schedule(struct chronos_grq *grq, int cpu)
+{
+	chronos_cpu = cpu;
+	return grq->sched->schedule(grq->flags);
+}
+
+/* Bottom-up merge sort, stable like the kernel's lib/list_sort.c */
+static struct list_head *merge(void *priv,
+			       int (*cmp)(void *, struct list_head *, struct list_head *),
+			       struct list_head *a, struct list_head *b)
+{
+	struct list_head head, *tail = &head;
+
+	while (a && b) {
+		if (cmp(priv, a, b) <= 0) {
+			tail->next = a;
+			a = a->next;
+		} else {
+			tail->next = b;
+			b = b->next;
+		}
+		tail = tail->next;
+	}
+	tail->next = a ? a : b;
+	return head.next;
+}
+
+void list_sort(void *priv, struct list_head *head,
+	       int (*cmp)(void *priv, struct list_head *a,
+			  struct list_head *b))
+{
+	struct list_head *part[64];
+	struct list_head *list, *next, *prev;
+	int lev, max_lev = 0;
+
+	if (list_empty(head))
+		return;
+
+	memset(part, 0, sizeof(part));
+	head->prev->next = NULL;
+	list = head->next;
+
+	while (list) {
+		struct list_head *cur = list;
+
+		list = list->next;
+		cur->next = NULL;
+
+		for (lev = 0; part[lev]; lev++) {
+			cur = merge(priv, cmp, part[lev], cur);
+			part[lev] = NULL;
+		}
+		if (lev > max_lev)
+			max_lev = lev;
+		part[lev] = cur;
+	}
+
+	list = NULL;
+	for (lev = 0; lev <= max_lev; lev++)
+		if (part[lev])
+			list = list ? merge(priv, cmp, part[lev], list) : part[lev];
+
+	// Restore the prev links
+	prev = head;
+	for (next = list; next; next = next->next) {
+		next->prev = prev;
+		prev->next = next;
+		prev = next;
+	}
+	prev->next = head;
+	head->prev = prev;
+}
@@ -0,0 +1,83 @@
+/* userspace/chronos.h
+ *
+ * Harness-side interface to the userspace ChronOS core: the simulated
+ * clock, the scheduler registry and the counters the benchmarks report.
+ */
+
+#ifndef _USERSPACE_CHRONOS_H
+#define _USERSPACE_CHRONOS_H
+
+#include <linux/chronos_types.h>
+#include <linux/chronos_sched.h>
+
+extern struct list_head chronos_local_schedulers;
+extern struct list_head chronos_global_schedulers;
+
+extern unsigned long chronos_printk_count;
+extern unsigned long chronos_alloc_count;
+extern unsigned long chronos_abort_count;
+
+void chronos_set_time(const struct timespec *now);
+// Give the calling thread a clock of its own
+void chronos_set_thread_time(const struct timespec *now);
+
+struct rt_sched_local *find_local_scheduler(const char *name);
+struct rt_sched_global *find_global_scheduler(const char *name);
+
+/*
+ * One CPU's ready queue under one scheduler. The head is an rt_info used
+ * only for its LOCAL_LIST, the same shape the ChronOS core hands to the
+ * schedulers.
+ */
+struct chronos_rq {
+	struct rt_info head;
+	struct rt_sched_local *sched;
+	int cpu;
+	int flags;
+};
+
+void chronos_rq_init(struct chronos_rq *rq, struct rt_sched_local *sched,
+		     int cpu, int flags);
+void chronos_rq_add(struct chronos_rq *rq, struct rt_info *task);
+void chronos_rq_add_batch(struct chronos_rq *rq, struct rt_info **tasks, int nr);
+void chronos_rq_remove(struct chronos_rq *rq, struct rt_info *task);
+void chronos_rq_complete(struct chronos_rq *rq, struct rt_info *task);
+void chronos_rq_clear(struct chronos_rq *rq);
+void chronos_rq_register_lock(struct chronos_rq *rq, struct rt_info *task,
+			      struct mutex_head *m);
+void chronos_rq_lock(struct chronos_rq *rq, struct rt_info *task,
+		     struct mutex_head *m);
+void chronos_rq_unlock(struct chronos_rq *rq, struct rt_info *task,
+		       struct mutex_head *m);
+void chronos_rq_block(struct chronos_rq *rq, struct rt_info *task,
+		      struct mutex_head *m);
+struct rt_info *chronos_rq_schedule(struct chronos_rq *rq);
+void chronos_rq_switch(struct chronos_rq *rq, struct rt_info *task, u64 ns);
+
+static inline struct list_head *chronos_rq_head(struct chronos_rq *rq)
+{
+	return &rq->head.task_list[LOCAL_LIST];
+}
+
+/*
+ * nr_cpus CPUs under one global scheduler. The scheduler keeps the ready
+ * queues itself; each call below is made from the thread playing the
+ * given CPU, and threads may call in concurrently. When the scheduler
+ * calls resched_cpu(), chronos_grq_need_resched() says so once.
+ */
+struct chronos_grq {
+	struct rt_sched_global *sched;
+	int nr_cpus;
+	int flags;
+};
+
+void chronos_grq_init(struct chronos_grq *grq, struct rt_sched_global *sched,
+		      int nr_cpus, int flags);
+void chronos_grq_add(struct chronos_grq *grq, struct rt_info *task, int cpu);
+void chronos_grq_remove(struct chronos_grq *grq, struct rt_info *task, int cpu);
+void chronos_grq_complete(struct chronos_grq *grq, struct rt_info *task,
+			  int cpu);
+struct rt_info *chronos_grq_schedule(struct chronos_grq *grq, int cpu);
+bool chronos_grq_need_resched(struct chronos_grq *grq, int cpu);
+
+#endif
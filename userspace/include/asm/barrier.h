@@ -0,0 +1,13 @@
+/* userspace/include/asm/barrier.h
+ *
+ * Userspace stand-in for the SMP memory barriers in <asm/barrier.h>.
+ */
+
+#ifndef _SHIM_ASM_BARRIER_H
+#define _SHIM_ASM_BARRIER_H
+
+#define smp_mb()	__atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define smp_rmb()	__atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define smp_wmb()	__atomic_thread_fence(__ATOMIC_RELEASE)
+
+#endif
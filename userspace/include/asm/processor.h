@@ -0,0 +1,15 @@
+/* userspace/include/asm/processor.h
+ *
+ * Userspace stand-in for cpu_relax() from <asm/processor.h>.
+ */
+
+#ifndef _SHIM_ASM_PROCESSOR_H
+#define _SHIM_ASM_PROCESSOR_H
+
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax()	__builtin_ia32_pause()
+#else
+#define cpu_relax()	__asm__ __volatile__("" ::: "memory")
+#endif
+
+#endif
@@ -0,0 +1,51 @@
+/* userspace/include/linux/bitops.h
+ *
+ * Userspace stand-in for the bitmap operations in <linux/bitops.h> and
+ * <linux/bitmap.h>.
+ */
+
+#ifndef _SHIM_LINUX_BITOPS_H
+#define _SHIM_LINUX_BITOPS_H
+
+#include <linux/kernel.h>
+
+#define BITS_PER_LONG		(8 * sizeof(long))
+#define BITS_TO_LONGS(nr)	(((nr) + BITS_PER_LONG - 1) / BITS_PER_LONG)
+#define BIT_WORD(nr)		((nr) / BITS_PER_LONG)
+#define BIT_MASK(nr)		(1UL << ((nr) % BITS_PER_LONG))
+
+#define DECLARE_BITMAP(name, bits)	unsigned long name[BITS_TO_LONGS(bits)]
+
+static inline void __set_bit(int nr, unsigned long *addr)
+{
+	addr[BIT_WORD(nr)] |= BIT_MASK(nr);
+}
+
+static inline void __clear_bit(int nr, unsigned long *addr)
+{
+	addr[BIT_WORD(nr)] &= ~BIT_MASK(nr);
+}
+
+static inline int test_bit(int nr, const unsigned long *addr)
+{
+	return (addr[BIT_WORD(nr)] & BIT_MASK(nr)) != 0;
+}
+
+static inline unsigned long __ffs(unsigned long word)
+{
+	return __builtin_ctzl(word);
+}
+
+// Index of the first set bit, or size if there is none
+static inline unsigned long find_first_bit(const unsigned long *addr,
+					   unsigned long size)
+{
+	unsigned long i;
+
+	for (i = 0; i * BITS_PER_LONG < size; i++)
+		if (addr[i])
+			return min(i * BITS_PER_LONG + __ffs(addr[i]), size);
+	return size;
+}
+
+#endif
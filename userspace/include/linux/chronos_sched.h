@@ -0,0 +1,99 @@
+/* userspace/include/linux/chronos_sched.h
+ *
+ * Userspace stand-in for the ChronOS scheduling helpers. The inline
+ * helpers match the kernel versions; everything else is implemented in
+ * userspace/chronos.c.
+ */
+
+#ifndef _SHIM_LINUX_CHRONOS_SCHED_H
+#define _SHIM_LINUX_CHRONOS_SCHED_H
+
+#include <linux/time.h>
+#include <linux/chronos_types.h>
+
+struct timespec current_kernel_time(void);
+#define CURRENT_TIME	(current_kernel_time())
+
+#define local_task(p)	list_entry(p, struct rt_info, task_list[LOCAL_LIST])
+
+static inline int task_check_flag(struct rt_info *r, int flag)
+{
+	return (r->flags & flag) != 0;
+}
+
+static inline void task_set_flag(struct rt_info *r, int flag)
+{
+	r->flags |= flag;
+}
+
+static inline void task_clear_flag(struct rt_info *r, int flag)
+{
+	r->flags &= ~flag;
+}
+
+static inline void add_ts(struct timespec *a, struct timespec *b,
+			  struct timespec *result)
+{
+	result->tv_sec = a->tv_sec + b->tv_sec;
+	result->tv_nsec = a->tv_nsec + b->tv_nsec;
+	if (result->tv_nsec >= NSEC_PER_SEC) {
+		result->tv_sec++;
+		result->tv_nsec -= NSEC_PER_SEC;
+	}
+}
+
+static inline void sub_ts(struct timespec *a, struct timespec *b,
+			  struct timespec *result)
+{
+	result->tv_sec = a->tv_sec - b->tv_sec;
+	result->tv_nsec = a->tv_nsec - b->tv_nsec;
+	if (result->tv_nsec < 0) {
+		result->tv_sec--;
+		result->tv_nsec += NSEC_PER_SEC;
+	}
+}
+
+static inline int compare_ts(struct timespec *a, struct timespec *b)
+{
+	if (a->tv_sec != b->tv_sec)
+		return a->tv_sec < b->tv_sec ? -1 : 1;
+	if (a->tv_nsec != b->tv_nsec)
+		return a->tv_nsec < b->tv_nsec ? -1 : 1;
+	return 0;
+}
+
+// Returns 1 if t1 is strictly before t2
+static inline int earlier_deadline(struct timespec *t1, struct timespec *t2)
+{
+	return compare_ts(t1, t2) < 0;
+}
+
+// Microseconds, as used for IVDs and priorities
+static inline long timespec_to_long(struct timespec *ts)
+{
+	return ts->tv_sec * USEC_PER_SEC + ts->tv_nsec / NSEC_PER_USEC;
+}
+
+long livd(struct rt_info *r, bool dep_inherit, int flags);
+int check_task_failure(struct rt_info *task, unsigned int flags);
+int check_task_aborted(struct rt_info *task);
+void abort_thread(struct rt_info *task);
+void update_left(struct rt_info *task);
+
+void initialize_lists(struct rt_info *task);
+void insert_on_list(struct rt_info *task, struct rt_info *list,
+		    int list_num, int sort_key, int before);
+void list_remove(struct rt_info *task, int list_num);
+
+struct rt_info *get_pi_task(struct rt_info *best, struct list_head *head,
+			    int flags);
+
+int add_local_scheduler(struct rt_sched_local *sched);
+void remove_local_scheduler(struct rt_sched_local *sched);
+int add_global_scheduler(struct rt_sched_global *sched);
+void remove_global_scheduler(struct rt_sched_global *sched);
+
+// Have cpu call its scheduler again soon, this one included
+void resched_cpu(int cpu);
+
+#endif
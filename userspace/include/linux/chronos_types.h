@@ -0,0 +1,172 @@
+/* userspace/include/linux/chronos_types.h
+ *
+ * Userspace stand-in for the ChronOS type definitions. Only the parts of
+ * struct rt_info and the scheduler descriptors that the modules in this
+ * tree touch are reproduced here.
+ */
+
+#ifndef _SHIM_LINUX_CHRONOS_TYPES_H
+#define _SHIM_LINUX_CHRONOS_TYPES_H
+
+#include <linux/kernel.h>
+#include <linux/list.h>
+#include <linux/types.h>
+
+// Lists embedded in every rt_info. LOCAL_LIST and GLOBAL_LIST belong to
+// the ChronOS core, the SCHED_LISTn are scratch space for the schedulers.
+#define LOCAL_LIST		0
+#define GLOBAL_LIST		1
+#define SCHED_LIST1		2
+#define SCHED_LIST2		3
+#define SCHED_LIST3		4
+#define SCHED_LIST4		5
+#define SCHED_LISTS		6
+
+// Per-task flags
+#define ABORTED			0x01
+#define MARKED			0x02
+#define DEADLOCKED		0x04
+// local_ivd is up to date with ivd_left and ivd_util (see ivd_cache.h)
+#define IVD_CACHED		0x08
+
+// Per-scheduler flags passed down from sched_test_app
+#define SCHED_FLAG_HUA		0x01
+#define SCHED_FLAG_PI		0x02
+#define SCHED_FLAG_NO_DEADLOCKS	0x04
+// Recompute every decision (see decision_cache.h)
+#define SCHED_FLAG_NO_CACHE	0x08
+
+// Keys the core can keep the ready queue sorted by
+#define SORT_KEY_NONE		0
+#define SORT_KEY_DEADLINE	1
+#define SORT_KEY_PERIOD		2
+#define SORT_KEY_LVD		3
+#define SORT_KEY_GVD		4
+#define SORT_KEY_TDEADLINE	5
+
+// Scheduler ids
+#define SCHED_RT_FIFO		0x00
+#define SCHED_RT_RMA		0x01
+#define SCHED_RT_EDF		0x02
+#define SCHED_RT_HVDF		0x03
+#define SCHED_RT_LBESA		0x04
+#define SCHED_RT_DASA_ND	0x05
+#define SCHED_RT_DASA		0x06
+#define SCHED_RT_ICPP		0x07
+#define SCHED_RT_HYBRID		0x08
+
+// Global schedulers have the top bit set
+#define SCHED_GLOBAL_MASK	0x80
+#define SCHED_RT_GEDF		(SCHED_GLOBAL_MASK | SCHED_RT_EDF)
+#define SCHED_RT_GDASA		(SCHED_GLOBAL_MASK | SCHED_RT_DASA_ND)
+
+struct rt_info;
+
+struct mutex_head {
+	int id;
+	struct rt_info *owner_t;
+
+	// For ceiling protocols: the highest priority (smallest
+	// dynamic_priority) of any task that uses it, or 0 if none is known,
+	// and the owner's dynamic_priority from before it took the lock
+	unsigned long ceiling;
+	unsigned long saved_priority;
+};
+
+struct rt_info {
+	// Real-time information, all as absolute times or durations
+	struct timespec deadline;
+	struct timespec temp_deadline;
+	struct timespec period;
+	struct timespec left;
+	struct timespec exec_time;
+
+	unsigned long max_util;
+	long local_ivd;
+	long global_ivd;
+
+	// What local_ivd was last computed from
+	struct timespec ivd_left;
+	unsigned long ivd_util;
+
+	unsigned long dynamic_priority;
+	int locks_held;
+
+	struct list_head task_list[SCHED_LISTS];
+
+	// Locking
+	struct mutex_head *requested_resource;
+	struct rt_info *dep;
+
+	unsigned char flags;
+	int cpu;
+
+	// Position in the scheduler's own per-CPU queue, for schedulers that
+	// keep one (see rt_sched_local.enqueue)
+	int heap_index;
+};
+
+struct rt_sched {
+	const char *name;
+	int id;
+	int sort_key;
+	struct list_head list;
+};
+
+/*
+ * enqueue and dequeue are optional. If set, the core calls them with the
+ * runqueue locked whenever a task joins (release) or leaves (completion,
+ * abort, blocking) the ready queue of task->cpu, so a scheduler can keep
+ * its own structure up to date instead of rebuilding it in schedule().
+ *
+ * enqueue_batch is optional as well. Releases that land on a CPU at the
+ * same instant, or within the core's release window of each other, are
+ * put on the ready queue in one pass and followed by one decision; the
+ * core then calls enqueue_batch once with all nr of them, in release
+ * order, instead of enqueue for each, so a scheduler can absorb them in
+ * one pass too. Without it, enqueue is called for each.
+ *
+ * lock, unlock and block are optional too. The core calls them with the
+ * runqueue locked right after task has become the owner of m (and
+ * locks_held has gone up), right after it has given m up (and locks_held
+ * has gone down), and right after it has found m taken and set
+ * requested_resource to it, for schedulers whose priorities depend on
+ * the locks held. Tasks that were blocked on m when it was given up are
+ * no longer blocked on its owner; they either take m or block again.
+ *
+ * register_lock is optional. The core calls it once for every lock a
+ * task uses and every task using it, before the task first runs, for
+ * schedulers that need to know up front who may take a lock (ceiling
+ * protocols). The runqueue of task->cpu is locked, and m may be held.
+ */
+struct rt_sched_local {
+	struct rt_sched base;
+	unsigned int flags;
+	struct rt_info *(*schedule)(struct list_head *head, int flags);
+	void (*enqueue)(struct rt_info *task, int flags);
+	void (*dequeue)(struct rt_info *task, int flags);
+	void (*enqueue_batch)(struct rt_info **tasks, int nr, int flags);
+	void (*register_lock)(struct rt_info *task, struct mutex_head *m,
+			      int flags);
+	void (*lock)(struct rt_info *task, struct mutex_head *m, int flags);
+	void (*unlock)(struct rt_info *task, struct mutex_head *m, int flags);
+	void (*block)(struct rt_info *task, struct mutex_head *m, int flags);
+};
+
+/*
+ * Global schedulers own every CPU and keep their own queues. The core
+ * takes no lock of its own around these. It calls enqueue on the CPU a
+ * job is released on, with task->cpu set to that CPU, and dequeue on the
+ * CPU that ran the task. schedule picks the next task for the calling
+ * CPU, or NULL to idle it. The scheduler may move a ready task to
+ * another CPU by changing task->cpu.
+ */
+struct rt_sched_global {
+	struct rt_sched base;
+	unsigned int flags;
+	struct rt_info *(*schedule)(int flags);
+	void (*enqueue)(struct rt_info *task, int flags);
+	void (*dequeue)(struct rt_info *task, int flags);
+};
+
+#endif
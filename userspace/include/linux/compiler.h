@@ -0,0 +1,22 @@
+/* userspace/include/linux/compiler.h
+ *
+ * Userspace stand-in for <linux/compiler.h>: READ_ONCE and WRITE_ONCE for
+ * the fields that one CPU publishes and others read without a lock, and
+ * the annotations that only mean something to the kernel.
+ */
+
+#ifndef _SHIM_LINUX_COMPILER_H
+#define _SHIM_LINUX_COMPILER_H
+
+#define READ_ONCE(x)		__atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define WRITE_ONCE(x, val)	__atomic_store_n(&(x), (val), __ATOMIC_RELAXED)
+
+#ifndef __always_inline
+#define __always_inline		inline __attribute__((always_inline))
+#endif
+
+#define __percpu
+#define __user
+#define ____cacheline_aligned_in_smp	__attribute__((aligned(64)))
+
+#endif
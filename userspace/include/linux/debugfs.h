@@ -0,0 +1,44 @@
+/* userspace/include/linux/debugfs.h
+ *
+ * Userspace stand-in for <linux/debugfs.h>. There is no debugfs here, so
+ * creating anything fails the way it does in a kernel built without it.
+ */
+
+#ifndef _SHIM_LINUX_DEBUGFS_H
+#define _SHIM_LINUX_DEBUGFS_H
+
+#include <linux/fs.h>
+#include <linux/types.h>
+
+struct dentry;
+
+static inline struct dentry *debugfs_create_dir(const char *name,
+						struct dentry *parent)
+{
+	return NULL;
+}
+
+static inline struct dentry *debugfs_create_file(const char *name, int mode,
+						 struct dentry *parent, void *data,
+						 const struct file_operations *fops)
+{
+	return NULL;
+}
+
+static inline struct dentry *debugfs_create_u32(const char *name, int mode,
+						struct dentry *parent, u32 *value)
+{
+	return NULL;
+}
+
+static inline struct dentry *debugfs_create_u64(const char *name, int mode,
+						struct dentry *parent, u64 *value)
+{
+	return NULL;
+}
+
+static inline void debugfs_remove_recursive(struct dentry *dentry)
+{
+}
+
+#endif
@@ -0,0 +1,8 @@
+/* userspace/include/linux/errno.h */
+
+#ifndef _SHIM_LINUX_ERRNO_H
+#define _SHIM_LINUX_ERRNO_H
+
+#include_next <linux/errno.h>
+
+#endif
@@ -0,0 +1,68 @@
+/* userspace/include/linux/fs.h
+ *
+ * Userspace stand-in for the parts of <linux/fs.h> that a debugfs file
+ * needs. Nothing here is ever called: the harness reads the modules'
+ * data directly instead of through files.
+ */
+
+#ifndef _SHIM_LINUX_FS_H
+#define _SHIM_LINUX_FS_H
+
+#include <sys/types.h>
+#include <string.h>
+#include <linux/compiler.h>
+#include <linux/types.h>
+
+struct module;
+#define THIS_MODULE	((struct module *) 0)
+
+struct inode {
+	void *i_private;
+};
+
+struct file {
+	void *private_data;
+};
+
+struct file_operations {
+	struct module *owner;
+	int (*open)(struct inode *, struct file *);
+	ssize_t (*read)(struct file *, char __user *, size_t, loff_t *);
+	loff_t (*llseek)(struct file *, loff_t, int);
+};
+
+static inline int simple_open(struct inode *inode, struct file *file)
+{
+	file->private_data = inode->i_private;
+	return 0;
+}
+
+static inline loff_t default_llseek(struct file *file, loff_t offset,
+				    int whence)
+{
+	return offset;
+}
+
+static inline ssize_t simple_read_from_buffer(void __user *to, size_t count,
+					      loff_t *ppos, const void *from,
+					      size_t available)
+{
+	loff_t pos = *ppos;
+
+	if (pos < 0)
+		return -22;	// EINVAL
+	if ((size_t) pos >= available || count == 0)
+		return 0;
+	if (count > available - pos)
+		count = available - pos;
+	memcpy(to, (const char *) from + pos, count);
+	*ppos = pos + count;
+	return count;
+}
+
+static inline loff_t no_llseek(struct file *file, loff_t offset, int whence)
+{
+	return -29;	// ESPIPE
+}
+
+#endif
@@ -0,0 +1,21 @@
+/* userspace/include/linux/gcd.h
+ *
+ * Userspace stand-in for <linux/gcd.h>.
+ */
+
+#ifndef _SHIM_LINUX_GCD_H
+#define _SHIM_LINUX_GCD_H
+
+static inline unsigned long gcd(unsigned long a, unsigned long b)
+{
+	unsigned long r;
+
+	while (b) {
+		r = a % b;
+		a = b;
+		b = r;
+	}
+	return a;
+}
+
+#endif
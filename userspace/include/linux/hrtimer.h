@@ -0,0 +1,66 @@
+/* userspace/include/linux/hrtimer.h
+ *
+ * Userspace stand-in for <linux/hrtimer.h>. The harnesses decide when to
+ * call the schedulers themselves, so timers are only recorded, never
+ * fired; a scheduler must not rely on one firing to stay correct.
+ */
+
+#ifndef _SHIM_LINUX_HRTIMER_H
+#define _SHIM_LINUX_HRTIMER_H
+
+#include <time.h>
+#include <linux/types.h>
+
+typedef s64 ktime_t;
+
+static inline ktime_t ns_to_ktime(u64 ns)
+{
+	return ns;
+}
+
+enum hrtimer_mode {
+	HRTIMER_MODE_ABS = 0x0,
+	HRTIMER_MODE_REL = 0x1,
+	HRTIMER_MODE_PINNED = 0x2,
+	HRTIMER_MODE_ABS_PINNED = 0x2,
+	HRTIMER_MODE_REL_PINNED = 0x3,
+};
+
+enum hrtimer_restart {
+	HRTIMER_NORESTART,
+	HRTIMER_RESTART,
+};
+
+struct hrtimer {
+	enum hrtimer_restart (*function)(struct hrtimer *);
+	ktime_t expires;
+	bool active;
+};
+
+static inline void hrtimer_init(struct hrtimer *timer, clockid_t clock,
+				enum hrtimer_mode mode)
+{
+	timer->function = NULL;
+	timer->expires = 0;
+	timer->active = false;
+}
+
+static inline int hrtimer_start(struct hrtimer *timer, ktime_t time,
+				enum hrtimer_mode mode)
+{
+	int was_active = timer->active;
+
+	timer->expires = time;
+	timer->active = true;
+	return was_active;
+}
+
+static inline int hrtimer_cancel(struct hrtimer *timer)
+{
+	int was_active = timer->active;
+
+	timer->active = false;
+	return was_active;
+}
+
+#endif
@@ -0,0 +1,45 @@
+/* userspace/include/linux/kernel.h
+ *
+ * Userspace stand-in for the bits of <linux/kernel.h> that the ChronOS
+ * scheduler modules use.
+ */
+
+#ifndef _SHIM_LINUX_KERNEL_H
+#define _SHIM_LINUX_KERNEL_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <time.h>
+#include <linux/types.h>
+
+#define likely(x)	__builtin_expect(!!(x), 1)
+#define unlikely(x)	__builtin_expect(!!(x), 0)
+
+#define min(x, y)	((x) < (y) ? (x) : (y))
+#define max(x, y)	((x) > (y) ? (x) : (y))
+#define min_t(type, x, y)	min((type) (x), (type) (y))
+
+#define ARRAY_SIZE(arr)	(sizeof(arr) / sizeof((arr)[0]))
+
+#define container_of(ptr, type, member) \
+	((type *)((char *)(ptr) - offsetof(type, member)))
+
+// Modules are built with their symbols hidden, like a .ko's; exporting
+// one makes it visible to the others again
+#define EXPORT_SYMBOL(sym) \
+	extern __typeof__(sym) sym __attribute__((visibility("default")))
+
+// printk is the single most expensive thing the UA schedulers do in the
+// kernel. Here it is only counted, so the benchmark can report how many
+// calls a decision makes without paying for console output.
+extern unsigned long chronos_printk_count;
+
+static inline int printk(const char *fmt, ...)
+{
+	__atomic_fetch_add(&chronos_printk_count, 1, __ATOMIC_RELAXED);
+	return 0;
+}
+
+#endif
@@ -0,0 +1,16 @@
+/* userspace/include/linux/list_sort.h
+ *
+ * Userspace stand-in for <linux/list_sort.h>; a stable merge sort with
+ * the same interface as lib/list_sort.c.
+ */
+
+#ifndef _SHIM_LINUX_LIST_SORT_H
+#define _SHIM_LINUX_LIST_SORT_H
+
+#include <linux/list.h>
+
+void list_sort(void *priv, struct list_head *head,
+	       int (*cmp)(void *priv, struct list_head *a,
+			  struct list_head *b));
+
+#endif
@@ -0,0 +1,25 @@
+/* userspace/include/linux/module.h
+ *
+ * Userspace stand-in for <linux/module.h>. module_init() and
+ * module_exit() become constructors and destructors, so linking a
+ * scheduler module into a program is enough to register it.
+ */
+
+#ifndef _SHIM_LINUX_MODULE_H
+#define _SHIM_LINUX_MODULE_H
+
+#include <linux/kernel.h>
+
+#define __init
+#define __exit
+
+#define module_init(fn) \
+	static void __attribute__((constructor)) __module_init(void) { fn(); }
+#define module_exit(fn) \
+	static void __attribute__((destructor)) __module_exit(void) { fn(); }
+
+#define MODULE_DESCRIPTION(s)
+#define MODULE_AUTHOR(s)
+#define MODULE_LICENSE(s)
+
+#endif
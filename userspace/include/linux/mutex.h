@@ -0,0 +1,28 @@
+/* userspace/include/linux/mutex.h
+ *
+ * Userspace stand-in for <linux/mutex.h>, on pthread mutexes.
+ */
+
+#ifndef _SHIM_LINUX_MUTEX_H
+#define _SHIM_LINUX_MUTEX_H
+
+#include <pthread.h>
+
+struct mutex {
+	pthread_mutex_t m;
+};
+
+#define DEFINE_MUTEX(name) \
+	struct mutex name = { PTHREAD_MUTEX_INITIALIZER }
+
+static inline void mutex_lock(struct mutex *lock)
+{
+	pthread_mutex_lock(&lock->m);
+}
+
+static inline void mutex_unlock(struct mutex *lock)
+{
+	pthread_mutex_unlock(&lock->m);
+}
+
+#endif
@@ -0,0 +1,43 @@
+/* userspace/include/linux/percpu.h
+ *
+ * Userspace stand-in for <linux/percpu.h>. Per-CPU variables are plain
+ * arrays indexed by the CPU the harness says it is running on. Each
+ * harness thread plays one CPU, so the current CPU is thread-local.
+ */
+
+#ifndef _SHIM_LINUX_PERCPU_H
+#define _SHIM_LINUX_PERCPU_H
+
+#include <linux/kernel.h>
+
+#define NR_CPUS		64
+
+extern __thread int chronos_cpu;
+extern int chronos_online_cpus;
+
+static inline int smp_processor_id(void)
+{
+	return chronos_cpu;
+}
+
+#define DEFINE_PER_CPU(type, name)	__typeof__(type) name[NR_CPUS]
+#define DECLARE_PER_CPU(type, name)	extern __typeof__(type) name[NR_CPUS]
+#define EXPORT_PER_CPU_SYMBOL(name)	EXPORT_SYMBOL(name)
+#define per_cpu(var, cpu)		((var)[cpu])
+#define per_cpu_ptr(ptr, cpu)		(&(*(ptr))[cpu])
+#define this_cpu_ptr(ptr)		per_cpu_ptr(ptr, smp_processor_id())
+#define get_cpu_var(var)		((var)[smp_processor_id()])
+#define put_cpu_var(var)		do { } while (0)
+#define __this_cpu_read(var)		((var)[smp_processor_id()])
+
+#define for_each_possible_cpu(cpu) \
+	for ((cpu) = 0; (cpu) < NR_CPUS; (cpu)++)
+#define for_each_online_cpu(cpu) \
+	for ((cpu) = 0; (cpu) < chronos_online_cpus; (cpu)++)
+
+static inline int num_online_cpus(void)
+{
+	return chronos_online_cpus;
+}
+
+#endif
@@ -0,0 +1,26 @@
+/* userspace/include/linux/sched.h
+ *
+ * Userspace stand-in for sched_clock() from <linux/sched.h>: a fast,
+ * monotonic ns clock for timing things on one CPU. set_need_resched()
+ * does nothing; the harnesses call the schedulers when they choose to.
+ */
+
+#ifndef _SHIM_LINUX_SCHED_H
+#define _SHIM_LINUX_SCHED_H
+
+#include <time.h>
+#include <linux/types.h>
+
+static inline u64 sched_clock(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline void set_need_resched(void)
+{
+}
+
+#endif
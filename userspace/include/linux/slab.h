@@ -0,0 +1,42 @@
+/* userspace/include/linux/slab.h
+ *
+ * Userspace stand-in for <linux/slab.h>. Every allocation is counted so
+ * the benchmark can report allocations per scheduling decision.
+ */
+
+#ifndef _SHIM_LINUX_SLAB_H
+#define _SHIM_LINUX_SLAB_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <linux/types.h>
+
+#define GFP_KERNEL	0
+#define GFP_ATOMIC	1
+
+extern unsigned long chronos_alloc_count;
+
+static inline void *kmalloc(size_t size, gfp_t gfp)
+{
+	__atomic_fetch_add(&chronos_alloc_count, 1, __ATOMIC_RELAXED);
+	return malloc(size);
+}
+
+static inline void *kzalloc(size_t size, gfp_t gfp)
+{
+	__atomic_fetch_add(&chronos_alloc_count, 1, __ATOMIC_RELAXED);
+	return calloc(1, size);
+}
+
+static inline void *krealloc(const void *p, size_t size, gfp_t gfp)
+{
+	__atomic_fetch_add(&chronos_alloc_count, 1, __ATOMIC_RELAXED);
+	return realloc((void *) p, size);
+}
+
+static inline void kfree(const void *p)
+{
+	free((void *) p);
+}
+
+#endif
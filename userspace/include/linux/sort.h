@@ -0,0 +1,19 @@
+/* userspace/include/linux/sort.h
+ *
+ * Userspace stand-in for <linux/sort.h>. The kernel's sort() is an
+ * unstable heapsort; qsort gives the same guarantees.
+ */
+
+#ifndef _SHIM_LINUX_SORT_H
+#define _SHIM_LINUX_SORT_H
+
+#include <stdlib.h>
+
+static inline void sort(void *base, size_t num, size_t size,
+			int (*cmp)(const void *, const void *),
+			void (*swap)(void *, void *, int))
+{
+	qsort(base, num, size, cmp);
+}
+
+#endif
@@ -0,0 +1,43 @@
+/* userspace/include/linux/spinlock.h
+ *
+ * Userspace stand-in for the raw spinlocks in <linux/spinlock.h>. A
+ * waiter yields instead of spinning: unlike in the kernel, the holder
+ * can be preempted, and there may be more simulated CPUs than real ones.
+ */
+
+#ifndef _SHIM_LINUX_SPINLOCK_H
+#define _SHIM_LINUX_SPINLOCK_H
+
+#include <sched.h>
+
+typedef struct {
+	int locked;
+} raw_spinlock_t;
+
+#define __RAW_SPIN_LOCK_UNLOCKED(name)	{ 0 }
+#define DEFINE_RAW_SPINLOCK(name) \
+	raw_spinlock_t name = __RAW_SPIN_LOCK_UNLOCKED(name)
+
+static inline void raw_spin_lock_init(raw_spinlock_t *lock)
+{
+	lock->locked = 0;
+}
+
+static inline int raw_spin_trylock(raw_spinlock_t *lock)
+{
+	return !__atomic_exchange_n(&lock->locked, 1, __ATOMIC_ACQUIRE);
+}
+
+static inline void raw_spin_lock(raw_spinlock_t *lock)
+{
+	while (!raw_spin_trylock(lock))
+		while (__atomic_load_n(&lock->locked, __ATOMIC_RELAXED))
+			sched_yield();
+}
+
+static inline void raw_spin_unlock(raw_spinlock_t *lock)
+{
+	__atomic_store_n(&lock->locked, 0, __ATOMIC_RELEASE);
+}
+
+#endif
@@ -0,0 +1,8 @@
+/* userspace/include/linux/string.h */
+
+#ifndef _SHIM_LINUX_STRING_H
+#define _SHIM_LINUX_STRING_H
+
+#include <string.h>
+
+#endif
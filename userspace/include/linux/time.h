@@ -0,0 +1,34 @@
+/* userspace/include/linux/time.h
+ *
+ * Userspace stand-in for the timespec helpers in <linux/time.h>.
+ */
+
+#ifndef _SHIM_LINUX_TIME_H
+#define _SHIM_LINUX_TIME_H
+
+#include <time.h>
+#include <linux/types.h>
+
+#define NSEC_PER_SEC	1000000000L
+#define NSEC_PER_USEC	1000L
+#define USEC_PER_SEC	1000000L
+
+static inline s64 timespec_to_ns(const struct timespec *ts)
+{
+	return ((s64) ts->tv_sec * NSEC_PER_SEC) + ts->tv_nsec;
+}
+
+static inline struct timespec ns_to_timespec(const s64 nsec)
+{
+	struct timespec ts;
+
+	ts.tv_sec = nsec / NSEC_PER_SEC;
+	ts.tv_nsec = nsec % NSEC_PER_SEC;
+	if (ts.tv_nsec < 0) {
+		ts.tv_sec--;
+		ts.tv_nsec += NSEC_PER_SEC;
+	}
+	return ts;
+}
+
+#endif
@@ -0,0 +1,29 @@
+/* userspace/include/linux/types.h
+ *
+ * Userspace stand-in for the fixed width kernel types. The uapi __u32
+ * style types come from the system header this one shadows.
+ */
+
+#ifndef _SHIM_LINUX_TYPES_H
+#define _SHIM_LINUX_TYPES_H
+
+#include_next <linux/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef int8_t s8;
+typedef uint8_t u8;
+typedef int16_t s16;
+typedef uint16_t u16;
+typedef int32_t s32;
+typedef uint32_t u32;
+typedef int64_t s64;
+typedef uint64_t u64;
+
+typedef unsigned int gfp_t;
+
+#define S64_MAX		INT64_MAX
+#define S64_MIN		INT64_MIN
+#define U64_MAX		UINT64_MAX
+
+#endif
@@ -0,0 +1,19 @@
+/* userspace/include/linux/uaccess.h
+ *
+ * Userspace stand-in for copy_to_user() from <linux/uaccess.h>.
+ */
+
+#ifndef _SHIM_LINUX_UACCESS_H
+#define _SHIM_LINUX_UACCESS_H
+
+#include <string.h>
+#include <linux/compiler.h>
+
+static inline unsigned long copy_to_user(void __user *to, const void *from,
+					 unsigned long n)
+{
+	memcpy(to, from, n);
+	return 0;
+}
+
+#endif
@@ -0,0 +1,146 @@
+/* userspace/partition.c
+ *
+ * Fill in the CPUs column of a sched_test_app task file by partitioning
+ * its tasks across CPUs with partition.h, for the given local scheduler.
+ *
+ * The task file is written to stdout with each task's CPU replaced.
+ * Tasks that fit on no CPU are commented out, and the exit status is 1.
+ * Per-CPU utilizations go to stderr.
+ *
+ * usage: partition [-s scheduler] [-m cpus] [-w] taskfile
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include "chronos.h"
+#include "../partition.h"
+
+#define MAX_LINE	1024
+
+struct line {
+	char text[MAX_LINE];
+	struct rt_info *task;
+};
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-s scheduler] [-m cpus] [-w] taskfile\n",
+		prog);
+	exit(2);
+}
+
+// Parse a "T cpu group wss period usage ..." line, times in us
+static struct rt_info *parse_task(const char *text)
+{
+	struct rt_info *task;
+	long long period, usage;
+	int cpu, group, wss;
+
+	if (sscanf(text, "T %d %d %d %lld %lld", &cpu, &group, &wss,
+		   &period, &usage) != 5)
+		return NULL;
+
+	task = calloc(1, sizeof(*task));
+	task->cpu = cpu;
+	task->period.tv_sec = period / USEC_PER_SEC;
+	task->period.tv_nsec = period % USEC_PER_SEC * NSEC_PER_USEC;
+	task->exec_time.tv_sec = usage / USEC_PER_SEC;
+	task->exec_time.tv_nsec = usage % USEC_PER_SEC * NSEC_PER_USEC;
+	return task;
+}
+
+// Print a task line with its CPU field replaced, keeping the layout
+static void print_task(const char *text, int cpu)
+{
+	const char *p = text + 1, *end;
+
+	while (isspace((unsigned char) *p))
+		p++;
+	end = p;
+	while (*end && !isspace((unsigned char) *end))
+		end++;
+
+	printf("%.*s%d%s", (int) (p - text), text, cpu, end);
+}
+
+int main(int argc, char **argv)
+{
+	struct rt_sched_local *sched = find_local_scheduler("EDF");
+	enum partition_fit fit = PARTITION_FIRST_FIT;
+	static struct partition p;
+	struct rt_info **tasks;
+	struct line *lines = NULL;
+	int nr_lines = 0, nr_tasks = 0, nr_cpus = 1;
+	int opt, i, rejected;
+	FILE *f;
+
+	while ((opt = getopt(argc, argv, "s:m:w")) != -1) {
+		switch (opt) {
+		case 's':
+			sched = find_local_scheduler(optarg);
+			if (sched == NULL) {
+				fprintf(stderr, "no scheduler named %s\n", optarg);
+				return 2;
+			}
+			break;
+		case 'm': nr_cpus = atoi(optarg); break;
+		case 'w': fit = PARTITION_WORST_FIT; break;
+		default: usage(argv[0]);
+		}
+	}
+	if (optind != argc - 1 || nr_cpus < 1 || nr_cpus > NR_CPUS)
+		usage(argv[0]);
+
+	f = fopen(argv[optind], "r");
+	if (f == NULL) {
+		perror(argv[optind]);
+		return 2;
+	}
+
+	for (;;) {
+		lines = realloc(lines, (nr_lines + 1) * sizeof(*lines));
+		if (fgets(lines[nr_lines].text, MAX_LINE, f) == NULL)
+			break;
+		lines[nr_lines].task = NULL;
+		if (lines[nr_lines].text[0] == 'T') {
+			lines[nr_lines].task = parse_task(lines[nr_lines].text);
+			if (lines[nr_lines].task == NULL) {
+				fprintf(stderr, "%s:%d: can't parse task\n",
+					argv[optind], nr_lines + 1);
+				return 2;
+			}
+			nr_tasks++;
+		}
+		nr_lines++;
+	}
+	fclose(f);
+
+	tasks = calloc(nr_tasks, sizeof(*tasks));
+	for (i = 0, nr_tasks = 0; i < nr_lines; i++)
+		if (lines[i].task)
+			tasks[nr_tasks++] = lines[i].task;
+
+	partition_init(&p, nr_cpus, partition_test_for(sched->base.id), fit);
+	rejected = partition_tasks(&p, tasks, nr_tasks);
+
+	for (i = 0; i < nr_lines; i++) {
+		if (lines[i].task == NULL)
+			fputs(lines[i].text, stdout);
+		else if (lines[i].task->cpu < 0)
+			printf("# does not fit: %s", lines[i].text);
+		else
+			print_task(lines[i].text, lines[i].task->cpu);
+	}
+
+	for (i = 0; i < nr_cpus; i++)
+		fprintf(stderr, "cpu %d: %d tasks, utilization %.6f\n", i,
+			p.cpu[i].nr, (double) p.cpu[i].util / PARTITION_UTIL_ONE);
+	if (rejected)
+		fprintf(stderr, "%d of %d tasks did not fit\n", rejected, nr_tasks);
+
+	partition_free(&p);
+	return rejected ? 1 : 0;
+}
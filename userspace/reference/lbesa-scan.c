@@ -0,0 +1,118 @@
+/* userspace/reference/lbesa-scan.c
+ *
+ * LBESA as it was before the slack tree and the shedding heap: every round
+ * walks the whole schedule to check it and scans it again for the task
+ * with the highest IVD. Only built into the benchmark, to check the
+ * current version against (bench -r LBESA_SCAN).
+ *
+ * The one change from the original is the insertion loop, which compared
+ * the wrong way round and built the schedule latest-deadline first. Tasks
+ * now go in ascending deadline order, after any with the same deadline.
+ *
+ * Author(s)
+ *	- Matthew Dellinger, mdelling@vt.edu
+ *
+ * Copyright (C) 2009-2012 Virginia Tech Real Time Systems Lab
+ */
+
+#include <linux/module.h>
+#include <linux/chronos_types.h>
+#include <linux/chronos_sched.h>
+#include <linux/list.h>
+//#include <limits.h>
+
+static inline int schedule_feasible(struct list_head * head, int i) {
+	struct rt_info * it;
+	struct timespec exec_ts = CURRENT_TIME;
+	list_for_each_entry(it, head, task_list[i]) {
+		add_ts(&exec_ts, &(it->left), &exec_ts);
+		if (earlier_deadline(&(it->deadline), &exec_ts)) return 0;
+	}
+	return 1;
+}
+
+struct rt_info* sched_lbesa_scan(struct list_head *head, int flags)
+{
+	struct list_head schedule;
+	const int SCHEDULE_LIST = SCHED_LIST1;
+
+	struct rt_info * it;
+	struct list_head * lit;
+
+	long ivd;
+	struct rt_info * unworthy;
+
+	struct timespec * t1;
+
+	INIT_LIST_HEAD(&schedule);
+
+	list_for_each_entry(it, head, task_list[LOCAL_LIST]) {
+		// if a task is aborted, return it
+		if (check_task_failure(it, flags)) return it;
+
+		// Calculate the inverse value density
+		livd(it, 0, flags);
+
+		initialize_lists(it);
+
+		// Insert into the schedule in EDF order
+		t1 = &it->deadline;
+		lit = &schedule;
+		while (!list_is_last(lit, &schedule)) {
+			if (earlier_deadline(t1, &(list_first_entry(
+					lit,
+					struct rt_info,
+					task_list[SCHEDULE_LIST]
+					)->deadline)))
+				break;
+			lit = lit->next;
+		}
+		list_add(&(it->task_list[SCHEDULE_LIST]), lit);
+	}
+
+	while (!list_empty(&schedule)) {
+		if (schedule_feasible(&schedule, SCHEDULE_LIST))
+			return list_first_entry(&schedule,
+						struct rt_info,
+						task_list[SCHEDULE_LIST]);
+		ivd = LONG_MIN;
+		unworthy = NULL;
+		list_for_each_entry(it, &schedule, task_list[SCHEDULE_LIST]) {
+			if (it->local_ivd >= ivd) {
+				ivd = it->local_ivd;
+				unworthy = it;
+			}
+		}
+
+		list_remove(unworthy, SCHEDULE_LIST);
+	}
+
+	return list_first_entry(head,
+				struct rt_info,
+				task_list[LOCAL_LIST]);
+}
+
+struct rt_sched_local lbesa_scan = {
+	.base.name = "LBESA_SCAN",
+	.base.id = SCHED_RT_LBESA,
+	.flags = 0,
+	.schedule = sched_lbesa_scan,
+	.base.sort_key = SORT_KEY_PERIOD,
+	.base.list = LIST_HEAD_INIT(lbesa_scan.base.list)
+};
+
+static int __init lbesa_scan_init(void)
+{
+	return add_local_scheduler(&lbesa_scan);
+}
+module_init(lbesa_scan_init);
+
+static void __exit lbesa_scan_exit(void)
+{
+	remove_local_scheduler(&lbesa_scan);
+}
+module_exit(lbesa_scan_exit);
+
+MODULE_DESCRIPTION("Reference LBESA for the ChronOS userspace benchmarks");
+MODULE_AUTHOR("Matthew Dellinger <matthew@mdelling.com>");
+MODULE_LICENSE("GPL");
@@ -0,0 +1,491 @@
+/* userspace/sim.c
+ *
+ * Discrete-event simulation of a sched_test_app task file under the
+ * scheduler modules, producing the rows of results*.csv without a test
+ * box.
+ *
+ * Each point runs the task set for the given number of simulated
+ * seconds on one CPU, with every task's usage scaled by the CPU usage
+ * as sched_test_app -c does. Job k of a task is released at k periods
+ * and due a period later. The scheduler decides at each release and
+ * completion (and each deadline, with SCHED_FLAG_HUA), and the job it
+ * picks runs until the next of those. Jobs released at the same instant
+ * go onto the ready queue together, through chronos_rq_add_batch(). With
+ * -w, a release is held back until any others due within that many us
+ * after it, and they are all released together then, as the core does
+ * with its release window. Late jobs run on to completion
+ * unless the scheduler aborts them; an aborted job leaves as soon as it
+ * is picked. Decisions take no simulated time.
+ *
+ * Tasks run without locks and without touching memory: sim refuses a
+ * task file whose Locks column has critical sections (analyze takes
+ * those), and ignores working set sizes.
+ *
+ * The test box's jobs took longer than their scaled usage, as the timer
+ * interrupts and the core's own work landed on them. With -e, every
+ * job's usage is stretched by that many percent on top of the scaling.
+ * With -e 5, the RMA rows of results.csv come out exactly, and those of
+ * results2.csv (10t_nl, -r 60) do at 16 of the 19 points. The other
+ * three are each within a few jobs, at a threshold where the real runs
+ * themselves were noisy. Without -e, results.csv is 1 job off at 0.95
+ * and 15 jobs off at 1.85. EDF and the utility accrual schedulers
+ * don't reproduce at any stretch. On the box they also paid for
+ * decisions and aborts in ways -o only partly models, so their rows
+ * are only close. check_sim.sh compares the two.
+ *
+ * The (scheduler, usage) points are spread over threads, each playing a
+ * CPU of its own, so runs are the same whatever the thread count. The
+ * counts come from that CPU's sched_stats, as they would on a test box.
+ * Prints results*.csv rows: scheduler, usage, jobs that met their
+ * deadline, jobs released, utility of the jobs that met their deadline,
+ * total utility, jobs aborted.
+ *
+ * With -L, each decision is timed with sched_clock(), and the rows go on
+ * with the 50th, 99th and 99.9th percentile and the longest decision in
+ * ns, the fraction of the simulated time the decisions would have taken,
+ * and the simulated seconds the point covered. With -t, a point stops
+ * after that many seconds of wall time, so a large task set under a slow
+ * scheduler still gives a row; its counts are then for the simulated
+ * time it got through.
+ *
+ * With -o, decisions are no longer free: each takes the simulated time
+ * it took to make, and a switch to a different job takes that many us
+ * more, which the core reports to sched_overhead.h. The job picked runs
+ * once they are over. -a turns on the overhead charge of the utility
+ * accrual schedulers' feasibility tests, and so their timing of their
+ * decisions (see sched_overhead.h). Both make the results depend on how
+ * fast the decisions were made, so runs can differ a little.
+ *
+ * usage: sim [-s scheduler] [-c min[:max[:step]]] [-r seconds]
+ *            [-f sched flags] [-w window us] [-j threads] [-L]
+ *            [-t seconds] [-o switch us] [-a] [-e percent] taskfile
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include "chronos.h"
+#include "../sched_overhead.h"
+#include "../sched_stats.h"
+
+#define MAX_LINE	1024
+
+struct task {
+	u64 period;
+	u64 usage;
+	unsigned long utility;
+};
+
+struct point {
+	struct rt_sched_local *sched;
+	int usage;
+	struct sched_stats stats;
+	unsigned long long total_utility;
+	// With -L, how long each decision took (ns) and in all
+	u64 *latency;
+	int nr_decisions, size;
+	u64 decision_ns;
+	// Simulated time covered, short of the duration if -t stopped it
+	u64 simulated;
+};
+
+struct sim {
+	struct chronos_rq rq;
+	struct rt_info *jobs;
+	// Jobs being released together
+	struct rt_info **batch;
+	// Index into jobs of each task's next job, and when it is released
+	int *next_job;
+	u64 *next_release;
+	int nr_jobs;
+};
+
+static struct task *tasks;
+static int nr_tasks;
+static struct point *points;
+static int nr_points, next_point;
+static u64 duration = 15 * NSEC_PER_SEC;
+static u64 window;
+static u64 time_limit;
+static u64 switch_ns;
+static int flags, timed, overhead;
+// Per mille of the scaled usage that a job takes, with -e
+static u64 stretch = 1000;
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-s scheduler] [-c min[:max[:step]]] "
+		"[-r seconds] [-f sched flags] [-w window us] [-j threads] "
+		"[-L] [-t seconds] [-o switch us] [-a] [-e percent] taskfile\n",
+		prog);
+	exit(2);
+}
+
+static void read_tasks(const char *path)
+{
+	char text[MAX_LINE], locks[MAX_LINE];
+	long long period, use;
+	unsigned long utility;
+	int line = 0, cpu, group, wss, fields;
+	FILE *f = fopen(path, "r");
+
+	if (f == NULL) {
+		perror(path);
+		exit(2);
+	}
+
+	while (fgets(text, sizeof(text), f)) {
+		line++;
+		if (text[0] != 'T')
+			continue;
+		fields = sscanf(text, "T %d %d %d %lld %lld %lu %s", &cpu, &group,
+				&wss, &period, &use, &utility, locks);
+		if (fields < 6 || period <= 0 || use < 0) {
+			fprintf(stderr, "%s:%d: can't parse task\n", path, line);
+			exit(2);
+		}
+		if (fields == 7 && strchr(locks, ':')) {
+			fprintf(stderr, "%s:%d: task takes locks, which sim doesn't "
+				"model\n", path, line);
+			exit(2);
+		}
+		tasks = realloc(tasks, (nr_tasks + 1) * sizeof(*tasks));
+		tasks[nr_tasks].period = period * NSEC_PER_USEC;
+		tasks[nr_tasks].usage = use * NSEC_PER_USEC;
+		tasks[nr_tasks].utility = utility;
+		nr_tasks++;
+	}
+	fclose(f);
+}
+
+static void ns_to_ts(u64 ns, struct timespec *ts)
+{
+	ts->tv_sec = ns / NSEC_PER_SEC;
+	ts->tv_nsec = ns % NSEC_PER_SEC;
+}
+
+static u64 ts_to_ns(const struct timespec *ts)
+{
+	return (u64) ts->tv_sec * NSEC_PER_SEC + ts->tv_nsec;
+}
+
+static void set_now(u64 ns)
+{
+	struct timespec now;
+
+	ns_to_ts(ns, &now);
+	chronos_set_thread_time(&now);
+}
+
+// Release every job due by now, together; returns when the next one is
+static u64 release_jobs(struct sim *s, struct point *p, u64 now)
+{
+	u64 next = U64_MAX;
+	struct rt_info *job;
+	int i, nr = 0;
+
+	for (i = 0; i < nr_tasks; i++) {
+		while (s->next_release[i] <= now && s->next_release[i] < duration) {
+			job = &s->jobs[s->next_job[i]++];
+			memset(job, 0, sizeof(*job));
+			ns_to_ts(tasks[i].period, &job->period);
+			ns_to_ts(s->next_release[i] + tasks[i].period, &job->deadline);
+			ns_to_ts(tasks[i].usage * p->usage / 100 * stretch / 1000,
+				 &job->exec_time);
+			job->left = job->exec_time;
+			job->max_util = tasks[i].utility;
+
+			// A task that fell behind can release more than one
+			if (nr == nr_tasks) {
+				chronos_rq_add_batch(&s->rq, s->batch, nr);
+				nr = 0;
+			}
+			s->batch[nr++] = job;
+
+			p->total_utility += tasks[i].utility;
+			s->next_release[i] += tasks[i].period;
+		}
+		if (s->next_release[i] < duration)
+			next = min(next, s->next_release[i]);
+	}
+	if (nr)
+		chronos_rq_add_batch(&s->rq, s->batch, nr);
+	return next;
+}
+
+// Hold the release at next back for any others within the window after it
+static u64 release_window(struct sim *s, u64 next)
+{
+	u64 last = next;
+	int i;
+
+	if (window == 0 || next == U64_MAX)
+		return next;
+
+	for (i = 0; i < nr_tasks; i++)
+		if (s->next_release[i] < duration &&
+		    s->next_release[i] <= next + window)
+			last = max(last, s->next_release[i]);
+	return last;
+}
+
+static u64 next_deadline(struct sim *s, u64 now)
+{
+	struct rt_info *it;
+	u64 next = U64_MAX, d;
+
+	list_for_each_entry(it, chronos_rq_head(&s->rq), task_list[LOCAL_LIST]) {
+		d = ts_to_ns(&it->deadline);
+		if (d > now)
+			next = min(next, d);
+	}
+	return next;
+}
+
+// Decide, adding the time it took to *cost with -o
+static struct rt_info *schedule(struct sim *s, struct point *p, u64 *cost)
+{
+	struct rt_info *job;
+	u64 start, ns;
+
+	if (!timed && !overhead)
+		return chronos_rq_schedule(&s->rq);
+
+	start = sched_clock();
+	job = chronos_rq_schedule(&s->rq);
+	ns = sched_clock() - start;
+	if (overhead)
+		*cost += ns;
+	if (!timed)
+		return job;
+
+	if (p->nr_decisions == p->size) {
+		p->size = p->size ? 2 * p->size : 4096;
+		p->latency = realloc(p->latency, p->size * sizeof(*p->latency));
+	}
+	p->latency[p->nr_decisions++] = ns;
+	p->decision_ns += ns;
+	return job;
+}
+
+static int u64_cmp(const void *a, const void *b)
+{
+	u64 x = *(const u64 *) a, y = *(const u64 *) b;
+
+	return x < y ? -1 : x > y;
+}
+
+static u64 percentile(struct point *p, int per_mille)
+{
+	if (p->nr_decisions == 0)
+		return 0;
+	return p->latency[(long) (p->nr_decisions - 1) * per_mille / 1000];
+}
+
+static void simulate(struct point *p, int cpu)
+{
+	struct sim s;
+	struct sched_stats before;
+	struct rt_info *job, *running = NULL;
+	u64 now = 0, next, left, end = 0, cost;
+	int i;
+
+	sched_stats_read(cpu, &before);
+	// Estimates from this CPU's earlier points don't carry over
+	memset(&per_cpu(sched_overheads, cpu), 0, sizeof(struct sched_overhead));
+	memset(&s, 0, sizeof(s));
+	s.next_job = calloc(nr_tasks, sizeof(*s.next_job));
+	s.next_release = calloc(nr_tasks, sizeof(*s.next_release));
+	for (i = 0; i < nr_tasks; i++) {
+		s.next_job[i] = s.nr_jobs;
+		s.nr_jobs += (duration + tasks[i].period - 1) / tasks[i].period;
+	}
+	s.jobs = calloc(s.nr_jobs, sizeof(*s.jobs));
+	s.batch = calloc(nr_tasks, sizeof(*s.batch));
+	chronos_rq_init(&s.rq, p->sched, cpu, flags);
+	if (time_limit)
+		end = sched_clock() + time_limit;
+
+	while (now < duration) {
+		if (end && sched_clock() >= end)
+			break;
+		set_now(now);
+		next = min(release_window(&s, release_jobs(&s, p, now)), duration);
+		if (flags & SCHED_FLAG_HUA)
+			next = min(next, next_deadline(&s, now));
+
+		job = NULL;
+		cost = 0;
+		while (!list_empty(chronos_rq_head(&s.rq))) {
+			job = schedule(&s, p, &cost);
+			if (job == NULL || !check_task_aborted(job))
+				break;
+			chronos_rq_remove(&s.rq, job);
+			job = NULL;
+		}
+
+		if (job != NULL && job != running && switch_ns) {
+			chronos_rq_switch(&s.rq, job, switch_ns);
+			cost += switch_ns;
+		}
+		running = job;
+
+		// The job only starts once the decisions and the switch are over
+		if (cost) {
+			if (now + cost >= next) {
+				now = next;
+				continue;
+			}
+			now += cost;
+			set_now(now);
+		}
+
+		if (job != NULL) {
+			left = ts_to_ns(&job->left);
+			if (now + left <= next) {
+				now += left;
+				set_now(now);
+				chronos_rq_complete(&s.rq, job);
+				running = NULL;
+				continue;
+			}
+			ns_to_ts(left - (next - now), &job->left);
+		}
+		now = next;
+	}
+
+	chronos_rq_clear(&s.rq);
+	p->simulated = min(now, duration);
+	if (timed)
+		qsort(p->latency, p->nr_decisions, sizeof(*p->latency), u64_cmp);
+
+	// This thread's CPU counted the run, on top of its earlier points
+	sched_stats_read(cpu, &p->stats);
+	p->stats.released -= before.released;
+	p->stats.met -= before.met;
+	p->stats.aborted -= before.aborted;
+	p->stats.utility -= before.utility;
+	free(s.jobs);
+	free(s.batch);
+	free(s.next_job);
+	free(s.next_release);
+}
+
+static void *run_points(void *arg)
+{
+	int i, cpu = (long) arg;
+
+	chronos_cpu = cpu;
+	while ((i = __atomic_fetch_add(&next_point, 1, __ATOMIC_RELAXED)) <
+	       nr_points)
+		simulate(&points[i], cpu);
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	struct rt_sched_local *s, *only = NULL;
+	int lo = 65, hi = 245, step = 10, nr_threads = 0;
+	struct timespec start, end;
+	pthread_t threads[NR_CPUS];
+	int opt, i, usage_pt, nr_scheds = 0;
+	double percent;
+
+	while ((opt = getopt(argc, argv, "s:c:r:f:w:j:Lt:o:ae:")) != -1) {
+		switch (opt) {
+		case 's':
+			only = find_local_scheduler(optarg);
+			if (only == NULL) {
+				fprintf(stderr, "no scheduler named %s\n", optarg);
+				return 2;
+			}
+			break;
+		case 'c':
+			hi = -1;
+			if (sscanf(optarg, "%d:%d:%d", &lo, &hi, &step) < 1)
+				usage(argv[0]);
+			if (hi < lo)
+				hi = lo;
+			break;
+		case 'r': duration = atof(optarg) * NSEC_PER_SEC; break;
+		case 'f': flags = strtol(optarg, NULL, 0); break;
+		case 'w': window = atof(optarg) * NSEC_PER_USEC; break;
+		case 'j': nr_threads = atoi(optarg); break;
+		case 'L': timed = 1; break;
+		case 't': time_limit = atof(optarg) * NSEC_PER_SEC; break;
+		case 'o':
+			overhead = 1;
+			switch_ns = atof(optarg) * NSEC_PER_USEC;
+			break;
+		case 'a': sched_overhead_enabled = 1; break;
+		case 'e':
+			percent = atof(optarg);
+			if (percent <= -100)
+				usage(argv[0]);
+			stretch = 1000 + percent * 10;
+			break;
+		default: usage(argv[0]);
+		}
+	}
+	if (optind != argc - 1 || lo < 0 || step < 1 || duration == 0)
+		usage(argv[0]);
+	if (nr_threads < 1)
+		nr_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	nr_threads = min(nr_threads, NR_CPUS);
+
+	read_tasks(argv[optind]);
+
+	list_for_each_entry(s, &chronos_local_schedulers, base.list)
+		nr_scheds++;
+	points = calloc(((hi - lo) / step + 1) * nr_scheds, sizeof(*points));
+	for (usage_pt = lo; usage_pt <= hi; usage_pt += step) {
+		list_for_each_entry(s, &chronos_local_schedulers, base.list) {
+			if (only && s != only)
+				continue;
+			points[nr_points].sched = s;
+			points[nr_points].usage = usage_pt;
+			nr_points++;
+		}
+	}
+	nr_threads = min(nr_threads, nr_points);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < nr_threads; i++)
+		pthread_create(&threads[i], NULL, run_points, (void *) (long) i);
+	for (i = 0; i < nr_threads; i++)
+		pthread_join(threads[i], NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	for (i = 0; i < nr_points; i++) {
+		printf("%s,%.2f,%llu,%llu,%llu,%llu,%llu",
+		       points[i].sched->base.name, points[i].usage / 100.0,
+		       (unsigned long long) points[i].stats.met,
+		       (unsigned long long) points[i].stats.released,
+		       (unsigned long long) points[i].stats.utility,
+		       points[i].total_utility,
+		       (unsigned long long) points[i].stats.aborted);
+		if (timed)
+			printf(",%llu,%llu,%llu,%llu,%.6f,%.3f",
+			       (unsigned long long) percentile(&points[i], 500),
+			       (unsigned long long) percentile(&points[i], 990),
+			       (unsigned long long) percentile(&points[i], 999),
+			       (unsigned long long) percentile(&points[i], 1000),
+			       points[i].simulated ? (double) points[i].decision_ns /
+			       points[i].simulated : 0,
+			       points[i].simulated / 1e9);
+		printf("\n");
+		free(points[i].latency);
+	}
+	fprintf(stderr, "%d points in %.3f s on %d threads\n", nr_points,
+		(end.tv_sec - start.tv_sec) +
+		(end.tv_nsec - start.tv_nsec) / 1e9, nr_threads);
+
+	free(points);
+	free(tasks);
+	return 0;
+}
@@ -0,0 +1,27 @@
+# userspace/stress.sh
+#
+# Runs every scheduler on generated task sets of 100, 1000 and 10000
+# tasks at the given CPU usages, timing each decision. Each row is sim's
+# with the task count in front: tasks, scheduler, usage, met, released,
+# utility, total utility, aborted, then decision latency p50, p99, p99.9
+# and max (ns), overhead fraction and simulated seconds.
+#
+# The taskgen args can't include -l, as sim refuses task sets that take
+# locks; -w is accepted but sim ignores working set sizes.
+#
+# usage: stress.sh [usages [seconds [wall seconds per point [taskgen args]]]]
+
+dir=`dirname $0`
+usages=${1:-80:160:40}
+seconds=${2:-5}
+limit=${3:-30}
+shift 3 2>/dev/null || shift $#
+set=`mktemp`
+rows=`mktemp`
+trap 'rm -f $set $rows' EXIT
+
+for n in 100 1000 10000; do
+	$dir/taskgen -n $n -p 10000:1000000 "$@" > $set || exit
+	$dir/sim -L -c $usages -r $seconds -t $limit $set > $rows || exit
+	sed "s/^/$n,/" $rows
+done
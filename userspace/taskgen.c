@@ -0,0 +1,263 @@
+/* userspace/taskgen.c
+ *
+ * Generate a synthetic sched_test_app task file, in the format of 5t_nl
+ * and 10t_nl, for as many tasks as wanted.
+ *
+ * Utilizations add up to the given total, drawn uniformly from all the
+ * ways of doing so: by UUniFast, or by Stafford's Randfixedsum, which
+ * also keeps each task's utilization at most 1 and so allows totals over
+ * one CPU's worth (partition then spreads such a set over CPUs). Periods
+ * are log-uniform between the given bounds, in us, and usages are
+ * utilization times period, at least 1 us.
+ *
+ * Utilities come from -v: uniform:lo:hi (the default, 1:50), const:v, or
+ * exp:mean. With -l, there are that many locks; each task takes up to
+ * the given number of them, distinct, holding each for up to the given
+ * fraction of its usage divided among them, written in the Locks column
+ * as analyze reads it (sim refuses such sets). Working set sizes are
+ * uniform between the bounds given with -w, in bytes; sim ignores them.
+ * Every task is on CPU 0 and in thread group 1.
+ *
+ * usage: taskgen [-n tasks] [-u utilization] [-a uunifast|randfixedsum]
+ *                [-p min:max period us] [-v utility] [-l locks[:per task[:cs]]]
+ *                [-w min:max wss] [-s seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <float.h>
+
+// Randfixedsum's transition table takes n^2 / 2 doubles
+#define RANDFIXEDSUM_MAX	4096
+
+enum utility_dist { UTILITY_UNIFORM, UTILITY_CONST, UTILITY_EXP };
+
+static unsigned long long rng_state = 88172645463325252ULL;
+
+static unsigned long long xorshift(void)
+{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 7;
+	rng_state ^= rng_state << 17;
+	return rng_state;
+}
+
+static double uniform(void)
+{
+	return (xorshift() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-n tasks] [-u utilization] "
+		"[-a uunifast|randfixedsum]\n"
+		"\t[-p min:max period us] [-v uniform:lo:hi|const:v|exp:mean]\n"
+		"\t[-l locks[:per task[:cs fraction]]] [-w min:max wss] "
+		"[-s seed]\n", prog);
+	exit(2);
+}
+
+static void uunifast(double *u, int n, double total)
+{
+	double next;
+	int i;
+
+	for (i = 0; i < n - 1; i++) {
+		next = total * pow(uniform(), 1.0 / (n - 1 - i));
+		u[i] = total - next;
+		total = next;
+	}
+	u[n - 1] = total;
+}
+
+/*
+ * n values in [0, 1] adding up to total, uniformly over that polytope,
+ * after R. Stafford's randfixedsum.m. Returns -1 if the table doesn't
+ * fit in memory.
+ */
+static int randfixedsum(double *x, int n, double total)
+{
+	double *w, *prev, *t, *s1, *s2, tmp1, tmp2, tmp3, sm, pr, sx, s;
+	int i, c, j, k, e;
+
+	k = (int) floor(total);
+	k = k > n - 1 ? n - 1 : k < 0 ? 0 : k;
+	s = total < k ? k : total > k + 1 ? k + 1 : total;
+
+	w = calloc(n + 1, sizeof(*w));
+	prev = calloc(n + 1, sizeof(*prev));
+	s1 = calloc(n, sizeof(*s1));
+	s2 = calloc(n, sizeof(*s2));
+	// Row r (1 to n - 1) of the table has r + 1 entries
+	t = malloc(((size_t) (n - 1) * (n + 2) / 2 + 1) * sizeof(*t));
+	if (!w || !prev || !s1 || !s2 || !t) {
+		free(w); free(prev); free(s1); free(s2); free(t);
+		return -1;
+	}
+
+	for (c = 0; c < n; c++) {
+		s1[c] = s - (k - c);
+		s2[c] = (k + n - c) - s;
+	}
+
+	// w is scaled to use the whole range of a double
+	prev[1] = DBL_MAX;
+	for (i = 2; i <= n; i++) {
+		memset(w, 0, (n + 1) * sizeof(*w));
+		for (c = 0; c < i; c++) {
+			tmp1 = prev[c + 1] * s1[c] / i;
+			tmp2 = prev[c] * s2[n - i + c] / i;
+			w[c + 1] = tmp1 + tmp2;
+			tmp3 = w[c + 1] + DBL_MIN;
+			t[(size_t) (i - 2) * (i + 1) / 2 + c] =
+				s2[n - i + c] > s1[c] ? tmp2 / tmp3 : 1 - tmp1 / tmp3;
+		}
+		memcpy(prev, w, (n + 1) * sizeof(*w));
+	}
+
+	// Walk back through the table, choosing a simplex and a point in it
+	j = k;
+	sm = 0;
+	pr = 1;
+	for (i = n - 1; i >= 1; i--) {
+		e = uniform() <= t[(size_t) (i - 1) * (i + 2) / 2 + j];
+		sx = pow(uniform(), 1.0 / i);
+		sm += (1 - sx) * pr * s / (i + 1);
+		pr *= sx;
+		x[n - 1 - i] = sm + pr * e;
+		s -= e;
+		j -= e;
+	}
+	x[n - 1] = sm + pr * s;
+
+	// The coordinates come out in no random order
+	for (i = n - 1; i > 0; i--) {
+		c = xorshift() % (i + 1);
+		tmp1 = x[i];
+		x[i] = x[c];
+		x[c] = tmp1;
+	}
+
+	free(w); free(prev); free(s1); free(s2); free(t);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	enum utility_dist dist = UTILITY_UNIFORM;
+	double total = 0.9, pmin = 500000, pmax = 5000000;
+	double ulo = 1, uhi = 50, cs = 0.1, *u;
+	long long period, use, wmin = 0, wmax = 0, wss;
+	int n = 10, nr_locks = 0, per_task = 1, fixedsum = 0;
+	int opt, i, j, l, nr, *taken;
+	char *p;
+
+	while ((opt = getopt(argc, argv, "n:u:a:p:v:l:w:s:")) != -1) {
+		switch (opt) {
+		case 'n': n = atoi(optarg); break;
+		case 'u': total = atof(optarg); break;
+		case 'a':
+			if (strcmp(optarg, "randfixedsum") == 0)
+				fixedsum = 1;
+			else if (strcmp(optarg, "uunifast") != 0)
+				usage(argv[0]);
+			break;
+		case 'p':
+			if (sscanf(optarg, "%lf:%lf", &pmin, &pmax) != 2)
+				usage(argv[0]);
+			break;
+		case 'v':
+			if (sscanf(optarg, "uniform:%lf:%lf", &ulo, &uhi) == 2)
+				dist = UTILITY_UNIFORM;
+			else if (sscanf(optarg, "const:%lf", &ulo) == 1)
+				dist = UTILITY_CONST;
+			else if (sscanf(optarg, "exp:%lf", &ulo) == 1)
+				dist = UTILITY_EXP;
+			else
+				usage(argv[0]);
+			break;
+		case 'l':
+			if (sscanf(optarg, "%d:%d:%lf", &nr_locks, &per_task, &cs) < 1)
+				usage(argv[0]);
+			break;
+		case 'w':
+			if (sscanf(optarg, "%lld:%lld", &wmin, &wmax) < 1)
+				usage(argv[0]);
+			if (wmax < wmin)
+				wmax = wmin;
+			break;
+		case 's': rng_state += strtoull(optarg, &p, 0); break;
+		default: usage(argv[0]);
+		}
+	}
+	if (optind != argc || n < 1 || total <= 0 || pmin < 1 || pmax < pmin ||
+	    uhi < ulo || nr_locks < 0 || per_task < 0 || cs < 0 || cs > 1)
+		usage(argv[0]);
+	if (per_task > nr_locks)
+		per_task = nr_locks;
+	if (!fixedsum && total > 1)
+		fprintf(stderr, "warning: UUniFast can give a task utilization "
+			"over 1; use -a randfixedsum\n");
+	if (fixedsum && total > n) {
+		fprintf(stderr, "utilization %g is more than %d tasks can have\n",
+			total, n);
+		return 2;
+	}
+
+	u = calloc(n, sizeof(*u));
+	taken = calloc(nr_locks + 1, sizeof(*taken));
+	if (!fixedsum) {
+		uunifast(u, n, total);
+	} else if (n > RANDFIXEDSUM_MAX || randfixedsum(u, n, total)) {
+		fprintf(stderr, "randfixedsum needs at most %d tasks\n",
+			RANDFIXEDSUM_MAX);
+		return 2;
+	}
+
+	printf("#the number of locks\nL\t%d\n", nr_locks);
+	printf("#\tCPUs\tThread group\tTask WSS (b)\tPeriod (us)\tUsage (us)\t"
+	       "Utility\t\tLocks\n");
+	for (i = 0; i < n; i++) {
+		period = llround(pmin * pow(pmax / pmin, uniform()));
+		use = llround(u[i] * period);
+		if (use < 1)
+			use = 1;
+		wss = wmin + (wmax > wmin ? xorshift() % (wmax - wmin + 1) : 0);
+
+		printf("T\t0\t1\t\t%lld\t\t%lld\t\t%lld\t\t", wss, period, use);
+		switch (dist) {
+		case UTILITY_UNIFORM:
+			printf("%.0f", floor(ulo + uniform() * (uhi - ulo + 1)));
+			break;
+		case UTILITY_CONST:
+			printf("%.0f", ulo);
+			break;
+		case UTILITY_EXP:
+			printf("%.0f", ceil(-ulo * log(1 - uniform())));
+			break;
+		}
+
+		// Distinct locks, by partial Fisher-Yates over taken[]
+		nr = per_task ? xorshift() % (per_task + 1) : 0;
+		for (l = 0; l < nr_locks; l++)
+			taken[l] = l;
+		if (nr_locks)
+			printf(nr ? "\t\t" : "\t\t0");
+		for (l = 0; l < nr; l++) {
+			j = l + xorshift() % (nr_locks - l);
+			opt = taken[j];
+			taken[j] = taken[l];
+			taken[l] = opt;
+			printf("%s%d:%lld", l ? "," : "", opt,
+			       (long long) (use * cs / nr * uniform()));
+		}
+		printf("\n");
+	}
+
+	free(u);
+	free(taken);
+	return 0;
+}